@@ -0,0 +1,345 @@
+/******************************************************************************
+	Description:	CAutoSequencer implementation
+	Class:			CAutoSequencer
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "AutoSequencer.h"
+
+#include <fstream>
+#include <sstream>
+#include <frc/DriverStation.h>
+#include <frc/Filesystem.h>
+///////////////////////////////////////////////////////////////////////////////
+
+// Routine file keywords.
+struct sAutoActionName {
+	const char*		m_pszName;
+	AutoAction		m_nAction;
+};
+static const sAutoActionName s_aActionNames[] = {
+	{"stop_drive",		eActionStopDrive},
+	{"follow",			eActionFollow},
+	{"shooter_on",		eActionShooterOn},
+	{"shooter_idle",	eActionShooterIdle},
+	{"shooter_stop",	eActionShooterStop},
+	{"intake_deploy",	eActionIntakeDeploy},
+	{"intake_retract",	eActionIntakeRetract},
+	{"intake_hold",		eActionIntakeHold},
+	{"intake_on",		eActionIntakeOn},
+	{"intake_off",		eActionIntakeOff},
+	{"back_on",			eActionBackOn},
+	{"back_off",		eActionBackOff},
+	{"vertical_on",		eActionVerticalOn},
+	{"vertical_shot",	eActionVerticalShot},
+	{"vertical_off",	eActionVerticalOff}
+};
+
+struct sAutoConditionName {
+	const char*		m_pszName;
+	AutoCondition	m_nCondition;
+	bool			m_bHasValue;
+};
+static const sAutoConditionName s_aConditionNames[] = {
+	{"never",				eWaitNever,				false},
+	{"time",				eWaitTime,				true},
+	{"elapsed",				eWaitElapsed,			true},
+	{"vertical_ball",		eWaitVerticalBall,		false},
+	{"no_vertical_ball",	eWaitNoVerticalBall,	false},
+	{"back_ball",			eWaitBackBall,			false},
+	{"no_back_ball",		eWaitNoBackBall,		false},
+	{"no_balls",			eWaitNoBalls,			false},
+	{"flywheel_ready",		eWaitFlywheelReady,		false},
+	{"shot_ready",			eWaitShotReady,			true},
+	{"trajectory_done",		eWaitTrajectoryDone,	false},
+	{"intake_down",			eWaitIntakeDown,		false},
+	{"intake_up",			eWaitIntakeUp,			false}
+};
+
+/******************************************************************************
+	Description:	CAutoSequencer constructor, init variables
+	Arguments:		CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer,
+					CIntake* pIntake, CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CAutoSequencer::CAutoSequencer(CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer, CIntake* pIntake, CTelemetry* pTelemetry)
+{
+	m_pDrive		= pDrive;
+	m_pShooter		= pShooter;
+	m_pTransfer		= pTransfer;
+	m_pIntake		= pIntake;
+	m_pTelemetry	= pTelemetry;
+	m_nStep			= -1;
+	m_nLastStep		= -1;
+	m_dStepStart	= 0.000;
+
+	for (int i = 0; i < nPathCount; i++)
+	{
+		m_anFirstStep[i] = 0;
+		m_anStepCount[i] = 0;
+	}
+
+	// Register dashboard values.
+	m_nStepHandle	= m_pTelemetry->RegisterNumber("Auto Step", 0.500);
+}
+
+/******************************************************************************
+	Description:	Read and compile every routine file. A file with an error is
+					reported and left out, so that path holds the robot stopped
+					in autonomous. Called while disabled, so edited
+					routines take effect without a redeploy of the program.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CAutoSequencer::Load()
+{
+	Stop();
+	m_vSteps.clear();
+
+	for (int nPath = 0; nPath < nPathCount; nPath++)
+	{
+		m_anFirstStep[nPath] = (int)m_vSteps.size();
+		m_anStepCount[nPath] = 0;
+
+		const char* pszName = GetRoutineName((Paths)nPath);
+		if (pszName == nullptr) continue;
+
+		const string strFile = frc::filesystem::GetDeployDirectory() + "/" + pszAutoRoutineDirectory + "/" + pszName + pszAutoRoutineExtension;
+		ifstream File(strFile);
+		if (!File.is_open()) continue;
+
+		string strLine;
+		string strError;
+		int nLine = 0;
+		bool bValid = true;
+		while (bValid && getline(File, strLine))
+		{
+			nLine++;
+			const size_t nComment = strLine.find('#');
+			if (nComment != string::npos) strLine.erase(nComment);
+			if (strLine.find_first_not_of(" \t\r") == string::npos) continue;
+
+			sAutoStep Step;
+			bValid = CompileLine(strLine, Step, strError);
+			if (bValid) m_vSteps.push_back(Step);
+		}
+
+		if (!bValid)
+		{
+			DriverStation::ReportError(strFile + ":" + to_string(nLine) + ": " + strError);
+			m_vSteps.resize(m_anFirstStep[nPath]);
+			continue;
+		}
+		m_anStepCount[nPath] = (int)m_vSteps.size() - m_anFirstStep[nPath];
+	}
+}
+
+/******************************************************************************
+	Description:	Start a path's routine and issue its first step's commands
+	Arguments:		Paths nPath
+	Returns:		bool - False if the path has no routine loaded
+******************************************************************************/
+bool CAutoSequencer::Start(Paths nPath)
+{
+	Stop();
+	if ((nPath < 0) || (nPath >= nPathCount) || (m_anStepCount[nPath] == 0)) return false;
+
+	m_nLastStep = m_anFirstStep[nPath] + m_anStepCount[nPath] - 1;
+	StartStep(m_anFirstStep[nPath], 0.000);
+	return true;
+}
+
+/******************************************************************************
+	Description:	Move to the next step once the current one's condition or
+					timeout is met. The last step holds until autonomous ends.
+	Arguments:		double dElapsed - Seconds since autonomous started
+	Returns:		Nothing
+******************************************************************************/
+void CAutoSequencer::Tick(double dElapsed)
+{
+	if ((m_nStep < 0) || (m_nStep >= m_nLastStep)) return;
+
+	const sAutoStep& Step = m_vSteps[m_nStep];
+	const bool bTimedOut = (Step.m_dTimeout > 0.000) && ((dElapsed - m_dStepStart) >= Step.m_dTimeout);
+	if (bTimedOut || IsConditionMet(Step, dElapsed)) StartStep(m_nStep + 1, dElapsed);
+}
+
+/******************************************************************************
+	Description:	Stop running the current routine, leaves the motors as the
+					last step set them
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CAutoSequencer::Stop()
+{
+	m_nStep		= -1;
+	m_nLastStep	= -1;
+}
+
+/******************************************************************************
+	Description:	Gets the routine file name for a path
+	Arguments:		Paths nPath
+	Returns:		const char* - File name without the extension, nullptr for
+					paths that stay in code
+******************************************************************************/
+const char* CAutoSequencer::GetRoutineName(Paths nPath)
+{
+	switch (nPath)
+	{
+		case eTestPath:			return "test_path";
+		case eDumbTaxi:			return "dumb_taxi";
+		case eTaxiShot:			return "taxi_shot";
+		case eTaxi2Shot:		return "taxi_2_shot";
+		case eLessDumbTaxi1:	return "less_dumb_taxi";
+		default:				return nullptr;
+	}
+}
+
+/******************************************************************************
+	Description:	Compile one line of a routine file
+	Arguments:		const string& strLine - Line without its comment
+					sAutoStep& Step - Filled in on success
+					string& strError - Why the line didn't compile
+	Returns:		bool - True if the line compiled
+******************************************************************************/
+bool CAutoSequencer::CompileLine(const string& strLine, sAutoStep& Step, string& strError)
+{
+	const size_t nColon = strLine.find(':');
+	if (nColon == string::npos)
+	{
+		strError = "missing ':' before the wait condition";
+		return false;
+	}
+
+	// Actions.
+	istringstream Actions(strLine.substr(0, nColon));
+	string strToken;
+	while (Actions >> strToken)
+	{
+		if (strToken == "drive")
+		{
+			if (!(Actions >> Step.m_dLeftVoltage >> Step.m_dRightVoltage))
+			{
+				strError = "drive needs left and right voltages";
+				return false;
+			}
+			Step.m_nActions |= eActionDrive;
+			continue;
+		}
+
+		bool bFound = false;
+		for (const sAutoActionName& Action : s_aActionNames)
+		{
+			if (strToken == Action.m_pszName)
+			{
+				Step.m_nActions |= Action.m_nAction;
+				bFound = true;
+				break;
+			}
+		}
+		if (!bFound)
+		{
+			strError = "unknown action '" + strToken + "'";
+			return false;
+		}
+	}
+
+	// Wait condition, then an optional timeout.
+	istringstream Condition(strLine.substr(nColon + 1));
+	if (!(Condition >> strToken))
+	{
+		strError = "missing wait condition";
+		return false;
+	}
+
+	const sAutoConditionName* pCondition = nullptr;
+	for (const sAutoConditionName& Name : s_aConditionNames)
+	{
+		if (strToken == Name.m_pszName) pCondition = &Name;
+	}
+	if (pCondition == nullptr)
+	{
+		strError = "unknown condition '" + strToken + "'";
+		return false;
+	}
+	Step.m_nCondition = pCondition->m_nCondition;
+	if (pCondition->m_bHasValue && !(Condition >> Step.m_dValue))
+	{
+		strError = strToken + " needs a time in seconds";
+		return false;
+	}
+
+	if (Condition >> strToken)
+	{
+		if ((strToken != "timeout") || !(Condition >> Step.m_dTimeout))
+		{
+			strError = "expected 'timeout <seconds>' after the condition";
+			return false;
+		}
+	}
+	if (Condition >> strToken)
+	{
+		strError = "unexpected '" + strToken + "' at the end of the line";
+		return false;
+	}
+
+	return true;
+}
+
+/******************************************************************************
+	Description:	Make a step current and issue its commands
+	Arguments:		int nStep - Index into m_vSteps
+					double dElapsed - Seconds since autonomous started
+	Returns:		Nothing
+******************************************************************************/
+void CAutoSequencer::StartStep(int nStep, double dElapsed)
+{
+	m_nStep			= nStep;
+	m_dStepStart	= dElapsed;
+	m_pTelemetry->SetNumber(m_nStepHandle, nStep);
+
+	const sAutoStep& Step = m_vSteps[nStep];
+	const unsigned nActions = Step.m_nActions;
+	if (nActions & eActionDrive)			m_pDrive->SetDriveSpeeds(Step.m_dLeftVoltage, Step.m_dRightVoltage);
+	if (nActions & eActionStopDrive)		m_pDrive->ForceStop();
+	if (nActions & eActionFollow)			m_pDrive->FollowTrajectory();
+	if (nActions & eActionShooterOn)		m_pShooter->StartFlywheelShot();
+	if (nActions & eActionShooterIdle)		m_pShooter->IdleStop();
+	if (nActions & eActionShooterStop)		m_pShooter->Stop();
+	if (nActions & eActionIntakeDeploy)		m_pIntake->MoveIntake(false);
+	if (nActions & eActionIntakeRetract)	m_pIntake->MoveIntake(true);
+	if (nActions & eActionIntakeHold)		m_pIntake->StopDeploy();
+	if (nActions & eActionIntakeOn)			m_pIntake->StartIntake();
+	if (nActions & eActionIntakeOff)		m_pIntake->StopIntake();
+	if (nActions & eActionBackOn)			m_pTransfer->StartBack();
+	if (nActions & eActionBackOff)			m_pTransfer->StopBack();
+	if (nActions & eActionVerticalOn)		m_pTransfer->StartVertical();
+	if (nActions & eActionVerticalShot)		m_pTransfer->StartVerticalShot();
+	if (nActions & eActionVerticalOff)		m_pTransfer->StopVertical();
+}
+
+/******************************************************************************
+	Description:	Check a step's wait condition
+	Arguments:		const sAutoStep& Step
+					double dElapsed - Seconds since autonomous started
+	Returns:		bool - True when the step is done
+******************************************************************************/
+bool CAutoSequencer::IsConditionMet(const sAutoStep& Step, double dElapsed)
+{
+	switch (Step.m_nCondition)
+	{
+		case eWaitTime:				return (dElapsed - m_dStepStart) >= Step.m_dValue;
+		case eWaitElapsed:			return dElapsed >= Step.m_dValue;
+		case eWaitVerticalBall:		return m_pTransfer->m_aBallLocations[0];
+		case eWaitNoVerticalBall:	return !m_pTransfer->m_aBallLocations[0];
+		case eWaitBackBall:			return m_pTransfer->m_aBallLocations[1];
+		case eWaitNoBackBall:		return !m_pTransfer->m_aBallLocations[1];
+		case eWaitNoBalls:			return !m_pTransfer->m_aBallLocations[0] && !m_pTransfer->m_aBallLocations[1];
+		case eWaitFlywheelReady:	return m_pShooter->m_bShooterFullSpeed;
+		case eWaitShotReady:		return (m_pShooter->GetReadyIn() >= 0.000) && (m_pShooter->GetReadyIn() <= Step.m_dValue);
+		case eWaitTrajectoryDone:	return m_pDrive->IsTrajectoryFinished();
+		case eWaitIntakeDown:		return m_pIntake->GetLimitSwitchState(false);
+		case eWaitIntakeUp:			return m_pIntake->GetLimitSwitchState(true);
+		default:					return false;
+	}
+}
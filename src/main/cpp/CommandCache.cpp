@@ -0,0 +1,87 @@
+/******************************************************************************
+	Description:	CCommandCache implementation
+	Class:			CCommandCache
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "CommandCache.h"
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CCommandCache constructor, init variables
+	Arguments:		CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CCommandCache::CCommandCache(CTelemetry* pTelemetry)
+{
+	m_pTelemetry	= pTelemetry;
+	m_dTimestamp	= 0.000;
+	m_nSent			= 0;
+	m_nSuppressed	= 0;
+
+	// Register dashboard values.
+	m_nSentHandle				= m_pTelemetry->RegisterNumber("CAN/Commands Sent", 0.500);
+	m_nSuppressedHandle			= m_pTelemetry->RegisterNumber("CAN/Commands Suppressed", 0.500);
+	m_nSuppressedPercentHandle	= m_pTelemetry->RegisterNumber("CAN/Commands Suppressed (%)", 0.100);
+}
+
+/******************************************************************************
+	Description:	Add a motor controller, called from subsystem constructors
+	Arguments:		None
+	Returns:		int - Handle for ShouldSend() and Set()
+******************************************************************************/
+int CCommandCache::Register()
+{
+	m_vCommands.emplace_back();
+	return (int)m_vCommands.size() - 1;
+}
+
+/******************************************************************************
+	Description:	Decide whether a command needs to go out, and if so record
+					it as sent
+	Arguments:		int nHandle - From Register()
+					int nMode - Phoenix ControlMode, or nCommandSparkDutyCycle
+					double dValue - Setpoint
+	Returns:		bool - True if the mode or value changed, or the last send
+					is older than dCommandKeepAlive
+******************************************************************************/
+bool CCommandCache::ShouldSend(int nHandle, int nMode, double dValue)
+{
+	sCommand& Command = m_vCommands[nHandle];
+	if (Command.m_bValid && (Command.m_nMode == nMode) && (Command.m_dValue == dValue) && ((m_dTimestamp - Command.m_dSentTime) < dCommandKeepAlive))
+	{
+		m_nSuppressed++;
+		return false;
+	}
+
+	Command.m_bValid	= true;
+	Command.m_nMode		= nMode;
+	Command.m_dValue	= dValue;
+	Command.m_dSentTime	= m_dTimestamp;
+	m_nSent++;
+	return true;
+}
+
+/******************************************************************************
+	Description:	Forget every command so the next one always goes out, used
+					when the robot changes mode
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CCommandCache::InvalidateAll()
+{
+	for (sCommand& Command : m_vCommands) Command.m_bValid = false;
+}
+
+/******************************************************************************
+	Description:	Publish the sent and suppressed counts
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CCommandCache::Publish()
+{
+	const uint64_t nTotal = m_nSent + m_nSuppressed;
+	m_pTelemetry->SetNumber(m_nSentHandle, (double)m_nSent);
+	m_pTelemetry->SetNumber(m_nSuppressedHandle, (double)m_nSuppressed);
+	m_pTelemetry->SetNumber(m_nSuppressedPercentHandle, (nTotal > 0) ? (100.000 * m_nSuppressed / nTotal) : 0.000);
+}
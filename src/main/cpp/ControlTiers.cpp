@@ -0,0 +1,116 @@
+/******************************************************************************
+	Description:	CControlTiers implementation
+	Class:			CControlTiers
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "ControlTiers.h"
+
+#include <cmath>
+#include <string>
+///////////////////////////////////////////////////////////////////////////////
+
+// Dashboard names, in ControlTier order.
+static const char* const s_apszTierNames[eTierCount] = {
+	"Fast",
+	"Slow"
+};
+
+/******************************************************************************
+	Description:	CControlTiers constructor, starts the fast tier callback
+	Arguments:		TimedRobot* pRobot, CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CControlTiers::CControlTiers(TimedRobot* pRobot, CTelemetry* pTelemetry)
+{
+	m_pTelemetry = pTelemetry;
+
+	for (int i = 0; i < eTierCount; i++)
+	{
+		const string strName = string("Tier/") + s_apszTierNames[i];
+		m_anPeriodMeanHandle[i]	= m_pTelemetry->RegisterNumber((strName + " Period Mean (ms)").c_str(), 0.010);
+		m_anJitterHandle[i]		= m_pTelemetry->RegisterNumber((strName + " Jitter (ms)").c_str(), 0.010);
+		m_anPeriodMaxHandle[i]	= m_pTelemetry->RegisterNumber((strName + " Period Max (ms)").c_str(), 0.010);
+		m_anRunTimeMaxHandle[i]	= m_pTelemetry->RegisterNumber((strName + " Run Time Max (ms)").c_str(), 0.010);
+	}
+
+	pRobot->AddPeriodic([this] { RunTier(eTierFast); }, units::second_t(dFastTierPeriod));
+}
+
+/******************************************************************************
+	Description:	Add work to a tier, callbacks run in the order registered
+	Arguments:		ControlTier nTier, function<void()> Callback
+	Returns:		Nothing
+******************************************************************************/
+void CControlTiers::Register(ControlTier nTier, function<void()> Callback)
+{
+	m_avCallbacks[nTier].push_back(move(Callback));
+}
+
+/******************************************************************************
+	Description:	Run the slow tier, called once per loop from RobotPeriodic
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CControlTiers::RunSlowTier()
+{
+	RunTier(eTierSlow);
+}
+
+/******************************************************************************
+	Description:	Write each tier's timing into the telemetry buffer
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CControlTiers::PublishStatistics()
+{
+	for (int i = 0; i < eTierCount; i++)
+	{
+		const sTierStatistics& Statistics = m_aStatistics[i];
+		const double dJitter = (Statistics.m_nCount > 2) ? sqrt(Statistics.m_dPeriodM2 / (Statistics.m_nCount - 1)) : 0.000;
+		m_pTelemetry->SetNumber(m_anPeriodMeanHandle[i], Statistics.m_dPeriodMean);
+		m_pTelemetry->SetNumber(m_anJitterHandle[i], dJitter);
+		m_pTelemetry->SetNumber(m_anPeriodMaxHandle[i], Statistics.m_dPeriodMax);
+		m_pTelemetry->SetNumber(m_anRunTimeMaxHandle[i], Statistics.m_dRunTimeMax);
+	}
+}
+
+/******************************************************************************
+	Description:	Clear every tier's timing, called when the robot changes
+					mode so each period is measured on its own
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CControlTiers::ResetStatistics()
+{
+	for (int i = 0; i < eTierCount; i++) m_aStatistics[i] = sTierStatistics();
+}
+
+/******************************************************************************
+	Description:	Run every callback on a tier and fold the time since the
+					last run into the tier's jitter numbers
+	Arguments:		int nTier
+	Returns:		Nothing
+******************************************************************************/
+void CControlTiers::RunTier(int nTier)
+{
+	sTierStatistics& Statistics = m_aStatistics[nTier];
+	const auto tStart = chrono::steady_clock::now();
+
+	// Welford's method over the periods, there is one less period than runs.
+	if (Statistics.m_nCount > 0)
+	{
+		const double dPeriod = chrono::duration<double, milli>(tStart - Statistics.m_tLastStart).count();
+		const double dDelta = dPeriod - Statistics.m_dPeriodMean;
+		Statistics.m_dPeriodMean += dDelta / Statistics.m_nCount;
+		Statistics.m_dPeriodM2 += dDelta * (dPeriod - Statistics.m_dPeriodMean);
+		Statistics.m_dPeriodMax = fmax(Statistics.m_dPeriodMax, dPeriod);
+	}
+	Statistics.m_tLastStart = tStart;
+	Statistics.m_nCount++;
+
+	for (const function<void()>& Callback : m_avCallbacks[nTier]) Callback();
+
+	const double dRunTime = chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count();
+	Statistics.m_dRunTimeMax = fmax(Statistics.m_dRunTimeMax, dRunTime);
+}
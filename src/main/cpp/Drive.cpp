@@ -5,26 +5,48 @@
 ******************************************************************************/
 
 #include "Drive.h"
+#include "LoopProfiler.h"
 
+#include <algorithm>
+#include <cmath>
 #include <frc/smartdashboard/SmartDashboard.h>
 ///////////////////////////////////////////////////////////////////////////////
 
 /******************************************************************************
     Description:	CRobotMain constructor, init variables
-	Arguments:		Joystick* pDriveController
+	Arguments:		Joystick* pDriveController, CTelemetry* pTelemetry,
+					const sSensorSnapshot* pSnapshot
 	Derived from:	Nothing
 ******************************************************************************/
-CDrive::CDrive(Joystick* pDriveController) 
+CDrive::CDrive(Joystick* pDriveController, CTelemetry* pTelemetry, const sSensorSnapshot* pSnapshot) 
 {
 	m_pDriveController		= pDriveController;
+	m_pTelemetry			= pTelemetry;
+	m_pSnapshot				= pSnapshot;
 	m_pTimer				= new Timer();
 	m_pLeadDriveMotor1		= new CFalconMotion(nLeadDriveMotor1);
 	m_pFollowMotor1			= new WPI_TalonFX(nFollowDriveMotor1);
 	m_pLeadDriveMotor2		= new CFalconMotion(nLeadDriveMotor2);
 	m_pFollowMotor2			= new WPI_TalonFX(nFollowDriveMotor2);
 	m_pRobotDrive			= new DifferentialDrive(*m_pLeadDriveMotor1->GetMotorPointer(), *m_pLeadDriveMotor2->GetMotorPointer());
+#ifdef __FRC_ROBORIO__
 	m_pGyro					= new AHRS(SerialPort::Port::kMXP);
+#endif
+	m_dSimulatedHeading		= 0.000;
+	m_dSimulatedHeadingZero	= 0.000;
+	m_pOdometry				= new DifferentialDriveOdometry(Rotation2d(degree_t(-GetGyroAngle())));
+	m_pTrajectoryConstants	= new CTrajectoryConstants();
+	m_pTrajectoryFollower	= new CTrajectoryFollower(kDriveKinematics, SimpleMotorFeedforward<units::meters>(kDefaultS, kDefaultV, kDefaultA), dDefaultProportional, dDefaultIntegral, dDefaultDerivative, units::second_t(dFastTierPeriod), m_pTelemetry);
 	m_bJoystickControl = false;
+	m_bFollowing			= false;
+	m_nPoseHistoryHead		= 0;
+	m_nPoseHistoryCount		= 0;
+	m_bAiming				= false;
+	m_bAimSettled			= false;
+	m_dAimGoal				= 0.000;
+	m_dAimForward			= 0.000;
+	m_dAimStartTime			= 0.000;
+	m_dAimSettleTime		= -1.000;
 }
 
 /******************************************************************************
@@ -40,8 +62,12 @@ CDrive::~CDrive()
 	delete m_pFollowMotor1;
 	delete m_pFollowMotor2;
 	delete m_pRobotDrive;
+#ifdef __FRC_ROBORIO__
 	delete m_pGyro;
+#endif
 	delete m_pOdometry;
+	delete m_pTrajectoryConstants;
+	delete m_pTrajectoryFollower;
 
 	m_pDriveController	= nullptr;
 	m_pLeadDriveMotor1	= nullptr;
@@ -49,8 +75,12 @@ CDrive::~CDrive()
 	m_pFollowMotor1		= nullptr;
 	m_pFollowMotor2		= nullptr;
 	m_pRobotDrive		= nullptr;
+#ifdef __FRC_ROBORIO__
 	m_pGyro				= nullptr;
+#endif
 	m_pOdometry			= nullptr;
+	m_pTrajectoryConstants	= nullptr;
+	m_pTrajectoryFollower	= nullptr;
 }
 
 /******************************************************************************
@@ -77,13 +107,49 @@ void CDrive::Init()
 	m_pFollowMotor1->SetInverted(true);
 	m_pFollowMotor2->Follow(*m_pLeadDriveMotor2->GetMotorPointer());
 
-	// Reset encoders and odometry
+	// Reset encoders and odometry, a heading lock from before is in the old gyro frame.
 	ResetOdometry();
-	m_pOdometry	= new DifferentialDriveOdometry(m_pGyro->GetRotation2d());
+	m_bFollowing = false;
+	m_bAiming = false;
+	m_bAimSettled = false;
+	m_dAimForward = 0.000;
+
+	// Register dashboard values.
+	m_nLeftPowerHandle		= m_pTelemetry->RegisterNumber("LeftMotorPower", 0.050);
+	m_nRightPowerHandle		= m_pTelemetry->RegisterNumber("RightMotorPower", 0.050);
+	m_nLeftVelocityHandle	= m_pTelemetry->RegisterNumber("Left Actual Velocity", 0.010);
+	m_nRightVelocityHandle	= m_pTelemetry->RegisterNumber("Right Actual Velocity", 0.010);
+	m_nLeftPositionHandle	= m_pTelemetry->RegisterNumber("Left Actual Position", 0.100);
+	m_nRightPositionHandle	= m_pTelemetry->RegisterNumber("Right Actual Position", 0.100);
+	m_nPoseXHandle			= m_pTelemetry->RegisterNumber("Odometry X (m)", 0.010);
+	m_nPoseYHandle			= m_pTelemetry->RegisterNumber("Odometry Y (m)", 0.010);
+	m_nPoseHeadingHandle	= m_pTelemetry->RegisterNumber("Odometry Heading (deg)", 0.500);
+	m_nAimErrorHandle		= m_pTelemetry->RegisterNumber("Aim Error (deg)", 0.100);
+	m_nAimSettleHandle		= m_pTelemetry->RegisterNumber("Aim Settle Time (ms)", 1.000);
 	
 	m_pTimer->Start();
 }
 
+/******************************************************************************
+    Description:	Declare the CAN signals the drive reads. Odometry and the
+					follower read the lead encoders every fast tier tick, and
+					the followers take their output from the leads.
+	Arguments:		CStatusFramePlanner* pPlanner
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::ConfigureStatusFrames(CStatusFramePlanner* pPlanner)
+{
+	for (CFalconMotion* pLead : {m_pLeadDriveMotor1, m_pLeadDriveMotor2})
+	{
+		const int nDevice = pLead->AddToStatusFramePlan(pPlanner);
+		pPlanner->Require(nDevice, eSignalOutput, 10);
+		pPlanner->Require(nDevice, eSignalVelocity, 10);
+		pPlanner->Require(nDevice, eSignalPosition, 10);
+	}
+	pPlanner->AddTalon(m_pFollowMotor1, eCanTalonFX);
+	pPlanner->AddTalon(m_pFollowMotor2, eCanTalonFX);
+}
+
 /******************************************************************************
     Description:	Tick function, ran every 20ms in TeleopPeriodic
 	Arguments:		None
@@ -91,6 +157,7 @@ void CDrive::Init()
 ******************************************************************************/
 void CDrive::Tick()
 {
+	PROFILE_SCOPE(eProfileDriveTick);
 	if (m_bJoystickControl)
 	{
 		double dXAxis = m_pDriveController->GetRawAxis(eRightAxisX);
@@ -104,17 +171,24 @@ void CDrive::Tick()
 		if (fabs(dXAxis) < dJoystickDeadzone) dXAxis = 0.0;
 		if (fabs(dYAxis) < dJoystickDeadzone) dYAxis = 0.0;
 
+		// While the heading is locked the fast tier does the turning, the driver can still
+		// drive forward and back, and turning the stick takes control back.
+		if (m_bAiming)
+		{
+			if (dXAxis != 0.0) StopAim();
+			else
+			{
+				m_dAimForward = -dYAxis * 12.000;
+				m_pRobotDrive->Feed();
+			}
+		}
+
 		// Set drivetrain powers to joystick controls.
-		m_pRobotDrive->ArcadeDrive(-dYAxis, dXAxis, false);
+		if (!m_bAiming) m_pRobotDrive->ArcadeDrive(-dYAxis, dXAxis, false);
 	}
 
 	// Update Smartdashboard values.
-    SmartDashboard::PutNumber("LeftMotorPower", m_pLeadDriveMotor2->GetMotorVoltage());
-    SmartDashboard::PutNumber("RightMotorPower", m_pLeadDriveMotor1->GetMotorVoltage());
-    SmartDashboard::PutNumber("Left Actual Velocity", (m_pLeadDriveMotor2->GetActual(false) / 39.3701));
-    SmartDashboard::PutNumber("Right Actual Velocity", (m_pLeadDriveMotor1->GetActual(false) / 39.3701));
-    SmartDashboard::PutNumber("Left Actual Position", m_pLeadDriveMotor2->GetActual(true));
-    SmartDashboard::PutNumber("Right Actual Position", m_pLeadDriveMotor1->GetActual(true));
+	UpdateTelemetry();
 }
 
 /******************************************************************************
@@ -127,14 +201,35 @@ void CDrive::ForceStop()
 	m_pLeadDriveMotor1->Stop();
 	m_pLeadDriveMotor2->Stop();
 	m_bJoystickControl = false;
+	m_bFollowing = false;
+	m_bAiming = false;
 
 	// Update Smartdashboard values.
-    SmartDashboard::PutNumber("LeftMotorPower", m_pLeadDriveMotor2->GetMotorVoltage());
-    SmartDashboard::PutNumber("RightMotorPower", m_pLeadDriveMotor1->GetMotorVoltage());
-    SmartDashboard::PutNumber("Left Actual Velocity", (m_pLeadDriveMotor2->GetActual(false) / 39.3701));
-    SmartDashboard::PutNumber("Right Actual Velocity", (m_pLeadDriveMotor1->GetActual(false) / 39.3701));
-    SmartDashboard::PutNumber("Left Actual Position", m_pLeadDriveMotor2->GetActual(true));
-    SmartDashboard::PutNumber("Right Actual Position", m_pLeadDriveMotor1->GetActual(true));
+	UpdateTelemetry();
+}
+
+/******************************************************************************
+    Description:	Writes the drive values into the telemetry buffer, they are
+					published with the rest of the dashboard in RobotPeriodic
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::UpdateTelemetry()
+{
+	// These dashboard keys have always shown motor 2 as left, keep them that way for the drivers.
+	m_pTelemetry->SetNumber(m_nLeftPowerHandle, m_pSnapshot->m_dRightVoltage);
+	m_pTelemetry->SetNumber(m_nRightPowerHandle, m_pSnapshot->m_dLeftVoltage);
+	m_pTelemetry->SetNumber(m_nLeftVelocityHandle, m_pSnapshot->m_dRightVelocity);
+	m_pTelemetry->SetNumber(m_nRightVelocityHandle, m_pSnapshot->m_dLeftVelocity);
+	m_pTelemetry->SetNumber(m_nLeftPositionHandle, m_pSnapshot->m_dRightPosition);
+	m_pTelemetry->SetNumber(m_nRightPositionHandle, m_pSnapshot->m_dLeftPosition);
+
+	const Pose2d Pose = GetPose();
+	m_pTelemetry->SetNumber(m_nPoseXHandle, Pose.X().value());
+	m_pTelemetry->SetNumber(m_nPoseYHandle, Pose.Y().value());
+	m_pTelemetry->SetNumber(m_nPoseHeadingHandle, Pose.Rotation().Degrees().value());
+	m_pTelemetry->SetNumber(m_nAimErrorHandle, m_bAiming ? (m_dAimGoal - m_pSnapshot->m_dHeading) : 0.000);
+	m_pTelemetry->SetNumber(m_nAimSettleHandle, m_dAimSettleTime * 1000.000);
 }
 
 /******************************************************************************
@@ -147,7 +242,10 @@ void CDrive::ResetOdometry()
 	m_pLeadDriveMotor1->ResetEncoderPosition();
 	m_pLeadDriveMotor2->ResetEncoderPosition();
 
-	m_pGyro->ZeroYaw();
+	ZeroGyro();
+	m_pOdometry->ResetPosition(Pose2d(), Rotation2d(degree_t(-GetGyroAngle())));
+	m_nPoseHistoryHead	= 0;
+	m_nPoseHistoryCount	= 0;
 }
 
 /******************************************************************************
@@ -171,14 +269,41 @@ void CDrive::SetDriveSafety(bool bDriveSafety)
 }
 
 /******************************************************************************
-    Description:	Follow a trajectory based on elapsed time
+    Description:	Follow the armed trajectory. The follower itself runs on the
+					fast tier, this keeps it enabled until the path finishes.
 	Arguments:		None
 	Returns:		Nothing
 ******************************************************************************/
 void CDrive::FollowTrajectory()
 {
 	SetDriveSafety(false);
-	m_pRamseteCommand->Execute();
+	m_bAiming = false;
+	if (!m_pTrajectoryFollower->IsFinished()) m_bFollowing = true;
+}
+
+/******************************************************************************
+    Description:	Fast tier tick, ran every dFastTierPeriod. Updates odometry
+					and, while following or aiming, sends the voltages right
+					after the pose they were computed from.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::FastTick()
+{
+	UpdateOdometry();
+	if (m_bAiming && !m_bFollowing) UpdateAim(m_aPoseHistory[(m_nPoseHistoryHead + nPoseHistorySize - 1) % nPoseHistorySize].m_dHeading);
+	if (!m_bFollowing) return;
+
+	if (m_pTrajectoryFollower->IsFinished())
+	{
+		SetDrivePowers(0_V, 0_V);
+		m_bFollowing = false;
+		return;
+	}
+
+	volt_t dLeftVoltage, dRightVoltage;
+	m_pTrajectoryFollower->Calculate(GetPose(), GetWheelSpeeds(), dLeftVoltage, dRightVoltage);
+	SetDrivePowers(dLeftVoltage, dRightVoltage);
 }
 
 /******************************************************************************
@@ -189,22 +314,17 @@ void CDrive::FollowTrajectory()
 void CDrive::SetTrajectory(Paths nPath)
 {
 	// Taxi pathes doesn't need to set a trajectory, as it's all time based...
-	if(nPath == eDumbTaxi || nPath == eTaxiShot || nPath == eTaxi2Shot) return;
+	m_bFollowing = false;
+	if(nPath == eDumbTaxi || nPath == eTaxiShot || nPath == eTaxi2Shot)
+	{
+		m_pTrajectoryFollower->Disarm();
+		return;
+	}
 
 	m_pTrajectoryConstants->SelectTrajectory(nPath);
-	m_Trajectory = m_pTrajectoryConstants->GetSelectedTrajectory();
-
-	m_pRamseteCommand = new frc2::RamseteCommand(
-        m_Trajectory, 
-        [this]() { return m_pOdometry->GetPose(); }, 
-        RamseteController(), 
-        SimpleMotorFeedforward<units::meters>(kDefaultS, kDefaultV, kDefaultA), 
-        kDriveKinematics, 
-        [this]() { return GetWheelSpeeds(); }, 
-        frc2::PIDController(dDefaultProportional, dDefaultIntegral, dDefaultDerivative), 
-        frc2::PIDController(dDefaultProportional, dDefaultIntegral, dDefaultDerivative), 
-        [this](auto left, auto right) { SetDrivePowers(left, right); }
-    );
+	m_pTrajectory = m_pTrajectoryConstants->GetSelectedTrajectoryPointer();
+
+	m_pTrajectoryFollower->Arm(m_pTrajectory);
 }
 
 /******************************************************************************
@@ -225,6 +345,8 @@ void CDrive::SetDrivePowers(volt_t dLeftVoltage, volt_t dRightVoltage)
 ******************************************************************************/
 void CDrive::SetDriveSpeeds(double dLeftVoltage, double dRightVoltage)
 {
+	m_bFollowing = false;
+	m_bAiming = false;
 	m_pLeadDriveMotor1->SetMotorVoltage(dLeftVoltage);
 	m_pLeadDriveMotor2->SetMotorVoltage(dRightVoltage);
 }
@@ -246,7 +368,7 @@ DifferentialDriveWheelSpeeds CDrive::GetWheelSpeeds()
 ******************************************************************************/
 bool CDrive::IsTrajectoryFinished()
 {
-	return m_pRamseteCommand->IsFinished();
+	return m_pTrajectoryFollower->IsFinished();
 }
 
 /******************************************************************************
@@ -262,11 +384,259 @@ void CDrive::GoForwardUntuned()
 }
 
 /******************************************************************************
-    Description:	Turns the robot in the direction of the angle
-	Arguments:		dTheta
+    Description:	Fuses the gyro with both drive encoders, publishes the new
+					pose and adds it to the pose history. Runs every fast tier
+					tick.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::UpdateOdometry()
+{
+	// Motor 1 is the left side, encoder positions are in inches.
+	sOdometrySample& Sample	= m_LatestOdometry.GetWriteBuffer();
+	Sample.m_dTimestamp		= (double)Timer::GetFPGATimestamp();
+	Sample.m_dHeading		= GetGyroAngle();
+	Sample.m_dLeftPosition	= m_pLeadDriveMotor1->GetActual(true);
+	Sample.m_dRightPosition	= m_pLeadDriveMotor2->GetActual(true);
+	Sample.m_Pose			= m_pOdometry->Update(Rotation2d(degree_t(-Sample.m_dHeading)), inch_t(Sample.m_dLeftPosition), inch_t(Sample.m_dRightPosition));
+
+	m_aPoseHistory[m_nPoseHistoryHead] = Sample;
+	m_nPoseHistoryHead = (m_nPoseHistoryHead + 1) % nPoseHistorySize;
+	if (m_nPoseHistoryCount < nPoseHistorySize) m_nPoseHistoryCount++;
+
+	m_LatestOdometry.Publish();
+}
+
+/******************************************************************************
+    Description:	Fills the drive part of the loop's sensor snapshot. Encoder
+					positions and heading come from the last odometry update
+					instead of being read again.
+	Arguments:		sSensorSnapshot& Snapshot
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::ReadSensors(sSensorSnapshot& Snapshot)
+{
+	m_LatestOdometry.Update();
+	const sOdometrySample& Sample = m_LatestOdometry.GetReadBuffer();
+
+	Snapshot.m_dLeftVoltage		= m_pLeadDriveMotor1->GetMotorVoltage();
+	Snapshot.m_dRightVoltage	= m_pLeadDriveMotor2->GetMotorVoltage();
+	Snapshot.m_dLeftVelocity	= m_pLeadDriveMotor1->GetActual(false) / 39.3701;
+	Snapshot.m_dRightVelocity	= m_pLeadDriveMotor2->GetActual(false) / 39.3701;
+	Snapshot.m_dLeftPosition	= Sample.m_dLeftPosition;
+	Snapshot.m_dRightPosition	= Sample.m_dRightPosition;
+	Snapshot.m_dHeading			= Sample.m_dHeading;
+}
+
+/******************************************************************************
+    Description:	Gets the newest odometry pose
+	Arguments:		None
+	Returns:		Pose2d - Field relative pose (m)
+******************************************************************************/
+Pose2d CDrive::GetPose()
+{
+	m_LatestOdometry.Update();
+	return m_LatestOdometry.GetReadBuffer().m_Pose;
+}
+
+/******************************************************************************
+    Description:	Finds the two pose history samples around a past time
+	Arguments:		double dTimestamp - FPGA time (s)
+					int& nOlder, int& nNewer - Set to the samples' indexes,
+					the same one when dTimestamp is outside the history
+					double& dRatio - Set to how far dTimestamp is from the
+					older sample towards the newer one
+	Returns:		bool - False if there is no history yet
+******************************************************************************/
+bool CDrive::GetHistoryAt(double dTimestamp, int& nOlder, int& nNewer, double& dRatio)
+{
+	if (m_nPoseHistoryCount == 0) return false;
+
+	// Walk back from the newest sample to the first one taken at or before dTimestamp.
+	nNewer = (m_nPoseHistoryHead + nPoseHistorySize - 1) % nPoseHistorySize;
+	nOlder = nNewer;
+	dRatio = 0.000;
+	if (dTimestamp >= m_aPoseHistory[nNewer].m_dTimestamp) return true;
+	for (int i = 1; i < m_nPoseHistoryCount; i++)
+	{
+		nOlder = (nNewer + nPoseHistorySize - 1) % nPoseHistorySize;
+		const sOdometrySample& Older = m_aPoseHistory[nOlder];
+		const sOdometrySample& Newer = m_aPoseHistory[nNewer];
+		if (Older.m_dTimestamp <= dTimestamp)
+		{
+			double dSpan = Newer.m_dTimestamp - Older.m_dTimestamp;
+			dRatio = (dSpan > 0.000) ? ((dTimestamp - Older.m_dTimestamp) / dSpan) : 0.000;
+			return true;
+		}
+		nNewer = nOlder;
+	}
+
+	// Older than anything we've kept, the oldest sample is the best we have.
+	return true;
+}
+
+/******************************************************************************
+    Description:	Gets the gyro heading at a past time, interpolated between
+					the two samples around it
+	Arguments:		double dTimestamp - FPGA time (s)
+	Returns:		double - Continuous gyro angle (degrees)
+******************************************************************************/
+double CDrive::GetHeadingAt(double dTimestamp)
+{
+	int nOlder, nNewer;
+	double dRatio;
+	if (!GetHistoryAt(dTimestamp, nOlder, nNewer, dRatio)) return GetGyroAngle();
+
+	const sOdometrySample& Older = m_aPoseHistory[nOlder];
+	const sOdometrySample& Newer = m_aPoseHistory[nNewer];
+	return Older.m_dHeading + ((Newer.m_dHeading - Older.m_dHeading) * dRatio);
+}
+
+/******************************************************************************
+    Description:	Gets the odometry pose at a past time, interpolated between
+					the two samples around it
+	Arguments:		double dTimestamp - FPGA time (s)
+	Returns:		Pose2d - Field relative pose (m)
+******************************************************************************/
+Pose2d CDrive::GetPoseAt(double dTimestamp)
+{
+	int nOlder, nNewer;
+	double dRatio;
+	if (!GetHistoryAt(dTimestamp, nOlder, nNewer, dRatio)) return GetPose();
+
+	// Turn by the continuous gyro change, the pose's rotation wraps. The gyro is clockwise positive.
+	const sOdometrySample& Older = m_aPoseHistory[nOlder];
+	const sOdometrySample& Newer = m_aPoseHistory[nNewer];
+	const Rotation2d Turn(degree_t(-(Newer.m_dHeading - Older.m_dHeading) * dRatio));
+	return Pose2d(Older.m_Pose.Translation() + ((Newer.m_Pose.Translation() - Older.m_Pose.Translation()) * dRatio), Older.m_Pose.Rotation() + Turn);
+}
+
+/******************************************************************************
+    Description:	Lock the heading onto a vision target. The camera angle is
+					turned into an absolute gyro heading using the heading when
+					the frame was captured, so the goal holds still between
+					frames and the fast tier closes the loop on the gyro.
+	Arguments:		double dTheta - Angle to the target when captured (degrees,
+					clockwise positive)
+					double dCaptureTime - FPGA time the frame was captured (s)
 	Returns:		Nothing
 ******************************************************************************/
-void CDrive::TurnByAngle(double dTheta)
+void CDrive::AimAtAngle(double dTheta, double dCaptureTime)
 {
-	m_pRobotDrive->ArcadeDrive(0.000, dTheta / 100, false);
+	AimAtHeading(GetHeadingAt(dCaptureTime) + dTheta);
+}
+
+/******************************************************************************
+    Description:	Lock the heading onto an absolute gyro heading, e.g. a
+					target track's bearing
+	Arguments:		double dGoal - Continuous gyro angle (degrees)
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::AimAtHeading(double dGoal)
+{
+	if (!m_bAiming)
+	{
+		// Start the profile from wherever the robot is and however fast it's turning.
+		m_AimSetpoint	= {degree_t(GetGyroAngle()), TrapezoidProfile<units::degrees>::Velocity_t(GetTurnRate())};
+		m_dAimForward	= 0.000;
+		m_bFollowing	= false;
+		m_bAiming		= true;
+	}
+	else if (fabs(dGoal - m_dAimGoal) <= dAimRetarget)
+	{
+		// Same target, just a fresher fix on it.
+		m_dAimGoal = dGoal;
+		return;
+	}
+
+	m_dAimGoal			= dGoal;
+	m_dAimStartTime		= (double)Timer::GetFPGATimestamp();
+	m_bAimSettled		= false;
+}
+
+/******************************************************************************
+    Description:	Release the heading lock and stop turning
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::StopAim()
+{
+	if (!m_bAiming) return;
+	m_bAiming = false;
+	m_dAimForward = 0.000;
+	SetDrivePowers(0_V, 0_V);
+}
+
+/******************************************************************************
+    Description:	Steps the heading lock's profile towards the goal and turns
+					to follow it, feedforward from the profile's rate plus a PD
+					correction on the gyro. Runs every fast tier tick.
+	Arguments:		double dHeading - This tick's gyro angle (degrees)
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::UpdateAim(double dHeading)
+{
+	const double dRate = GetTurnRate();
+
+	const TrapezoidProfile<units::degrees>::Constraints Constraints{TrapezoidProfile<units::degrees>::Velocity_t(dAimMaxRate), TrapezoidProfile<units::degrees>::Acceleration_t(dAimMaxAcceleration)};
+	TrapezoidProfile<units::degrees> Profile(Constraints, {degree_t(m_dAimGoal), TrapezoidProfile<units::degrees>::Velocity_t(0.000)}, m_AimSetpoint);
+	m_AimSetpoint = Profile.Calculate(second_t(dFastTierPeriod));
+
+	const double dSetpointRate	= m_AimSetpoint.velocity.value();
+	const double dError			= m_AimSetpoint.position.value() - dHeading;
+	double dVoltage = (dAimVelocityFeedForward * dSetpointRate) + (dAimProportional * dError) + (dAimDerivative * (dSetpointRate - dRate));
+
+	// Static friction, in the profile's direction while it's moving, then towards the goal until settled.
+	const double dDirection = (dSetpointRate != 0.000) ? dSetpointRate : ((fabs(dError) > (dAimTolerance / 2.000)) ? dError : 0.000);
+	if (dDirection != 0.000) dVoltage += copysign(kDefaultS.value(), dDirection);
+	dVoltage = clamp(dVoltage, -dAimMaxVoltage, dAimMaxVoltage);
+
+	// Clockwise is positive, so the left side drives forward to turn that way.
+	SetDrivePowers(volt_t(m_dAimForward + dVoltage), volt_t(m_dAimForward - dVoltage));
+
+	if (!m_bAimSettled && (fabs(m_dAimGoal - dHeading) < dAimTolerance) && (fabs(dRate) < dAimRateTolerance))
+	{
+		m_bAimSettled		= true;
+		m_dAimSettleTime	= (double)Timer::GetFPGATimestamp() - m_dAimStartTime;
+	}
+}
+
+/******************************************************************************
+    Description:	Gets the turn rate from the drive encoders, smoother than
+					differentiating the gyro at the fast tier rate
+	Arguments:		None
+	Returns:		double - Turn rate (degrees/s, clockwise positive)
+******************************************************************************/
+double CDrive::GetTurnRate()
+{
+	return -degrees_per_second_t(kDriveKinematics.ToChassisSpeeds(GetWheelSpeeds()).omega).value();
+}
+
+/******************************************************************************
+    Description:	Gets the continuous gyro angle. Desktop builds have no navX
+					library, so the angle comes from CRobotSim instead.
+	Arguments:		None
+	Returns:		double - Gyro angle (degrees, clockwise positive)
+******************************************************************************/
+double CDrive::GetGyroAngle()
+{
+#ifdef __FRC_ROBORIO__
+	return m_pGyro->GetAngle();
+#else
+	return m_dSimulatedHeading - m_dSimulatedHeadingZero;
+#endif
+}
+
+/******************************************************************************
+    Description:	Zeroes the gyro yaw
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CDrive::ZeroGyro()
+{
+#ifdef __FRC_ROBORIO__
+	m_pGyro->ZeroYaw();
+#else
+	m_dSimulatedHeadingZero = m_dSimulatedHeading;
+#endif
 }
\ No newline at end of file
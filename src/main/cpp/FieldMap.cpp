@@ -0,0 +1,235 @@
+/******************************************************************************
+	Description:	CFieldMap implementation
+	Class:			CFieldMap
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "FieldMap.h"
+
+#include <algorithm>
+#include <cmath>
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CFieldMap constructor, init variables
+	Arguments:		CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CFieldMap::CFieldMap(CTelemetry* pTelemetry)
+{
+	m_pTelemetry	= pTelemetry;
+	m_dLastFrame	= 0.000;
+	m_abSeen.fill(false);
+
+	// Register dashboard values.
+	m_nRedHandle	= m_pTelemetry->RegisterNumber("Field Map Red Cargo", 0.500);
+	m_nBlueHandle	= m_pTelemetry->RegisterNumber("Field Map Blue Cargo", 0.500);
+}
+
+/******************************************************************************
+	Description:	Add a frame's cargo to the map, then weaken every cell the
+					camera could see that held no cargo in this frame. Does
+					nothing for a frame that was already used.
+	Arguments:		const CVisionPacket* pPacket - Latest packet, may be null
+					const Pose2d& Pose - Odometry pose when the frame was
+					captured
+	Returns:		Nothing
+******************************************************************************/
+void CFieldMap::Update(const CVisionPacket* pPacket, const Pose2d& Pose)
+{
+	if ((pPacket == nullptr) || (pPacket->m_dTimestamp <= m_dLastFrame)) return;
+	const double dTime = pPacket->m_dTimestamp;
+	m_dLastFrame = dTime;
+
+	// Camera direction in the field, counter-clockwise positive like the pose. The back camera looks the other way.
+	const double dCameraAngle = Pose.Rotation().Degrees().value() + ((pPacket->m_kDetectionLocation == eBackCamera) ? 180.000 : 0.000);
+
+	m_abSeen.fill(false);
+	const CDetectionBatch& Batch = pPacket->m_Batch;
+	const sDetectionMask Cargo = Batch.MatchClass(eRedCargo) | Batch.MatchClass(eBlueCargo);
+	for (int i = Cargo.Next(0); i >= 0; i = Cargo.Next(i + 1))
+	{
+		const int nLayer = GetLayer((DetectionClass)Batch.m_anClass[i]);
+		if (Batch.m_anDepth[i] <= 0) continue;
+
+		// Pixels to the right are clockwise of the camera's direction.
+		const double dRange = Batch.m_anDepth[i] / 1000.000;
+		const double dAngle = (dCameraAngle - Batch.GetBearing(i)) * (M_PI / 180.000);
+		const double dX = Pose.X().value() + (dRange * cos(dAngle));
+		const double dY = Pose.Y().value() + (dRange * sin(dAngle));
+		const int nCell = GetCell(dX, dY);
+		if (nCell < 0) continue;
+
+		sCell& Cell = m_aLayers[nLayer][nCell];
+		const double dEvidence = GetEvidence(Cell, dTime);
+		Cell.m_dX			= ((Cell.m_dX * dEvidence) + dX) / (dEvidence + 1.000);
+		Cell.m_dY			= ((Cell.m_dY * dEvidence) + dY) / (dEvidence + 1.000);
+		Cell.m_dEvidence	= dEvidence + 1.000;
+		Cell.m_dTime		= dTime;
+		m_abSeen[nCell]		= true;
+	}
+
+	// Cargo the camera should have seen this frame but didn't has probably moved or been taken.
+	for (array<sCell, nFieldMapColumns * nFieldMapRows>& Layer : m_aLayers)
+	{
+		for (int nCell = 0; nCell < (int)Layer.size(); nCell++)
+		{
+			sCell& Cell = Layer[nCell];
+			if ((Cell.m_dEvidence == 0.000) || m_abSeen[nCell]) continue;
+
+			const double dDeltaX = Cell.m_dX - Pose.X().value();
+			const double dDeltaY = Cell.m_dY - Pose.Y().value();
+			const double dRange = hypot(dDeltaX, dDeltaY);
+			if ((dRange < dFieldMapMinRange) || (dRange > dFieldMapMaxRange)) continue;
+
+			const double dOffAxis = remainder((atan2(dDeltaY, dDeltaX) * (180.000 / M_PI)) - dCameraAngle, 360.000);
+			if (fabs(dOffAxis) > dCameraHalfFieldOfView) continue;
+
+			Cell.m_dEvidence	= GetEvidence(Cell, dTime) * dFieldMapMissScale;
+			Cell.m_dTime		= dTime;
+			if (Cell.m_dEvidence < dFieldMapForget) Cell = sCell();
+		}
+	}
+}
+
+/******************************************************************************
+	Description:	Clear cargo under the robot, it has been picked up or
+					pushed away. Called every loop with the newest pose.
+	Arguments:		const Pose2d& Pose, double dTime - FPGA time (s)
+	Returns:		Nothing
+******************************************************************************/
+void CFieldMap::ClearFootprint(const Pose2d& Pose, double dTime)
+{
+	const int nColumn = GetColumn(Pose.X().value());
+	const int nRow = GetRow(Pose.Y().value());
+	for (int nY = max(nRow - 1, 0); nY <= min(nRow + 1, nFieldMapRows - 1); nY++)
+	{
+		for (int nX = max(nColumn - 1, 0); nX <= min(nColumn + 1, nFieldMapColumns - 1); nX++)
+		{
+			for (array<sCell, nFieldMapColumns * nFieldMapRows>& Layer : m_aLayers)
+			{
+				sCell& Cell = Layer[(nY * nFieldMapColumns) + nX];
+				if ((Cell.m_dEvidence != 0.000) && (hypot(Cell.m_dX - Pose.X().value(), Cell.m_dY - Pose.Y().value()) < dFieldMapFootprint)) Cell = sCell();
+			}
+		}
+	}
+}
+
+/******************************************************************************
+	Description:	Forget all cargo, used when odometry is reset since the map
+					is relative to the odometry origin
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CFieldMap::Reset()
+{
+	for (array<sCell, nFieldMapColumns * nFieldMapRows>& Layer : m_aLayers) Layer.fill(sCell());
+}
+
+/******************************************************************************
+	Description:	Find the nearest confirmed cargo of a colour. Searches rings
+					of cells outwards from the robot and stops as soon as no
+					further ring can hold anything closer, so the cost depends
+					on how far away the cargo is, not how big the map is.
+	Arguments:		DetectionClass kClass - eRedCargo or eBlueCargo
+					const Translation2d& From - Usually the robot's position
+					double dTime - FPGA time (s)
+					Translation2d& Cargo - Set to the cargo's position
+	Returns:		bool - False if the map holds no cargo of that colour
+******************************************************************************/
+bool CFieldMap::FindNearest(DetectionClass kClass, const Translation2d& From, double dTime, Translation2d& Cargo)
+{
+	const int nLayer = GetLayer(kClass);
+	if (nLayer < 0) return false;
+	const array<sCell, nFieldMapColumns * nFieldMapRows>& Layer = m_aLayers[nLayer];
+
+	const int nColumn = GetColumn(From.X().value());
+	const int nRow = GetRow(From.Y().value());
+	const int nMaxRing = max(nFieldMapColumns, nFieldMapRows);
+
+	double dBest = HUGE_VAL;
+	for (int nRing = 0; nRing <= nMaxRing; nRing++)
+	{
+		// Cells in this ring are at least (nRing - 1) cells away, nothing out here can beat what we have.
+		if (dBest <= ((nRing - 1) * dFieldMapCellSize)) break;
+
+		for (int nY = nRow - nRing; nY <= nRow + nRing; nY++)
+		{
+			if ((nY < 0) || (nY >= nFieldMapRows)) continue;
+
+			// Only the ring's edge, the inside was searched already.
+			const int nStep = ((nY == nRow - nRing) || (nY == nRow + nRing)) ? 1 : max(2 * nRing, 1);
+			for (int nX = nColumn - nRing; nX <= nColumn + nRing; nX += nStep)
+			{
+				if ((nX < 0) || (nX >= nFieldMapColumns)) continue;
+
+				const sCell& Cell = Layer[(nY * nFieldMapColumns) + nX];
+				if ((Cell.m_dEvidence == 0.000) || (GetEvidence(Cell, dTime) < dFieldMapConfirmed)) continue;
+
+				const double dDistance = hypot(Cell.m_dX - From.X().value(), Cell.m_dY - From.Y().value());
+				if (dDistance < dBest)
+				{
+					dBest = dDistance;
+					Cargo = Translation2d(units::meter_t(Cell.m_dX), units::meter_t(Cell.m_dY));
+				}
+			}
+		}
+	}
+
+	return dBest != HUGE_VAL;
+}
+
+/******************************************************************************
+	Description:	Write how much confirmed cargo of each colour the map holds
+					into the telemetry buffer
+	Arguments:		double dTime - FPGA time (s)
+	Returns:		Nothing
+******************************************************************************/
+void CFieldMap::Publish(double dTime)
+{
+	int anCount[2] = {0, 0};
+	for (int nLayer = 0; nLayer < 2; nLayer++)
+	{
+		for (const sCell& Cell : m_aLayers[nLayer])
+		{
+			if ((Cell.m_dEvidence != 0.000) && (GetEvidence(Cell, dTime) >= dFieldMapConfirmed)) anCount[nLayer]++;
+		}
+	}
+	m_pTelemetry->SetNumber(m_nRedHandle, anCount[0]);
+	m_pTelemetry->SetNumber(m_nBlueHandle, anCount[1]);
+}
+
+/******************************************************************************
+	Description:	Gets the layer a detection class is mapped in
+	Arguments:		DetectionClass kClass
+	Returns:		int - Layer index, negative for classes that aren't mapped
+******************************************************************************/
+int CFieldMap::GetLayer(DetectionClass kClass)
+{
+	if (kClass == eRedCargo) return 0;
+	if (kClass == eBlueCargo) return 1;
+	return -1;
+}
+
+/******************************************************************************
+	Description:	Gets the cell holding a field position
+	Arguments:		double dX, double dY - Odometry position (m)
+	Returns:		int - Cell index, negative if off the map
+******************************************************************************/
+int CFieldMap::GetCell(double dX, double dY)
+{
+	const int nColumn = GetColumn(dX);
+	const int nRow = GetRow(dY);
+	if ((nColumn < 0) || (nColumn >= nFieldMapColumns) || (nRow < 0) || (nRow >= nFieldMapRows)) return -1;
+	return (nRow * nFieldMapColumns) + nColumn;
+}
+
+/******************************************************************************
+	Description:	Gets a cell's evidence decayed to a time
+	Arguments:		const sCell& Cell, double dTime - FPGA time (s)
+	Returns:		double - Evidence
+******************************************************************************/
+double CFieldMap::GetEvidence(const sCell& Cell, double dTime)
+{
+	return Cell.m_dEvidence * exp(-max(dTime - Cell.m_dTime, 0.000) / dFieldMapDecayTime);
+}
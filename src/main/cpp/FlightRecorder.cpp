@@ -0,0 +1,256 @@
+/******************************************************************************
+	Description:	CFlightRecorder implementation
+	Class:			CFlightRecorder
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CFlightRecorder constructor, init variables
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CFlightRecorder::CFlightRecorder()
+{
+	m_nHead			= 0;
+	m_nTail			= 0;
+	m_nDropped		= 0;
+	m_bRunning		= false;
+	m_bRotate		= false;
+	m_nFile			= -1;
+	m_pHeader		= nullptr;
+	m_pRecords		= nullptr;
+	m_nMappedSize	= 0;
+}
+
+/******************************************************************************
+	Description:	CFlightRecorder destructor, flush and close the log
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CFlightRecorder::~CFlightRecorder()
+{
+	Stop();
+}
+
+/******************************************************************************
+	Description:	Open a new log file and start the writer thread
+	Arguments:		const string& strDirectory - Created if it doesn't exist
+	Returns:		bool - True if the log file could be opened
+******************************************************************************/
+bool CFlightRecorder::Start(const string& strDirectory)
+{
+	if (m_bRunning) return true;
+	m_strDirectory = strDirectory;
+	if (!OpenLogFile()) return false;
+
+	m_bRunning	= true;
+	m_Thread	= thread(&CFlightRecorder::WriterThread, this);
+	return true;
+}
+
+/******************************************************************************
+	Description:	Stop the writer thread, drain what's left and close the log
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CFlightRecorder::Stop()
+{
+	if (!m_bRunning) return;
+
+	m_bRunning = false;
+	if (m_Thread.joinable()) m_Thread.join();
+	Drain();
+	CloseLogFile();
+}
+
+/******************************************************************************
+	Description:	Close the current log file and start the next one. Called
+					from the robot loop, the writer thread does the file work
+					and records keep going into the ring meanwhile.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CFlightRecorder::Rotate()
+{
+	if (m_bRunning) m_bRotate = true;
+}
+
+/******************************************************************************
+	Description:	Copy a record into the ring. Called from the robot loop, this
+					never blocks; if the writer has fallen behind the record is
+					dropped and counted.
+	Arguments:		const sFlightRecord& Record
+	Returns:		bool - False if the record was dropped
+******************************************************************************/
+bool CFlightRecorder::Record(const sFlightRecord& Record)
+{
+	const unsigned int nHead = m_nHead.load(memory_order_relaxed);
+	if ((nHead - m_nTail.load(memory_order_acquire)) >= nFlightRecorderRingSize)
+	{
+		m_nDropped.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+
+	m_aRing[nHead & (nFlightRecorderRingSize - 1)] = Record;
+	m_nHead.store(nHead + 1, memory_order_release);
+	return true;
+}
+
+/******************************************************************************
+	Description:	Create the file after the newest flight_N.bin, size it for
+					a full match and map it into memory
+	Arguments:		None
+	Returns:		bool - True on success
+******************************************************************************/
+bool CFlightRecorder::OpenLogFile()
+{
+	mkdir(m_strDirectory.c_str(), 0755);
+
+	// The roboRIO clock isn't set before the FMS connects, so number the files instead of dating them.
+	int nNewest = -1;
+	DIR* pDirectory = opendir(m_strDirectory.c_str());
+	if (pDirectory != nullptr)
+	{
+		for (dirent* pEntry = readdir(pDirectory); pEntry != nullptr; pEntry = readdir(pDirectory))
+		{
+			int nIndex;
+			if (sscanf(pEntry->d_name, "flight_%d.bin", &nIndex) == 1) nNewest = max(nNewest, nIndex);
+		}
+		closedir(pDirectory);
+	}
+
+	const string strPath = m_strDirectory + "/flight_" + to_string(nNewest + 1) + ".bin";
+	m_nFile = open(strPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (m_nFile < 0) return false;
+	PruneLogFiles(nNewest + 1);
+
+	m_nMappedSize = sizeof(sFlightRecorderHeader) + (nFlightRecorderFileRecords * sizeof(sFlightRecord));
+	if (ftruncate(m_nFile, m_nMappedSize) != 0)
+	{
+		CloseLogFile();
+		return false;
+	}
+
+	void* pMapped = mmap(nullptr, m_nMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_nFile, 0);
+	if (pMapped == MAP_FAILED)
+	{
+		CloseLogFile();
+		return false;
+	}
+
+	m_pHeader				= (sFlightRecorderHeader*)pMapped;
+	m_pRecords				= (sFlightRecord*)(m_pHeader + 1);
+	m_pHeader->m_nMagic		= nFlightRecorderMagic;
+	m_pHeader->m_nVersion	= nFlightRecorderVersion;
+	m_pHeader->m_nRecordSize= sizeof(sFlightRecord);
+	m_pHeader->m_nCapacity	= nFlightRecorderFileRecords;
+	m_pHeader->m_nCount		= 0;
+	m_pHeader->m_nDropped	= 0;
+	m_nDropped				= 0;
+	return true;
+}
+
+/******************************************************************************
+	Description:	Delete every log file more than nFlightRecorderMaxFiles
+					behind the newest
+	Arguments:		int nNewest - Index of the file just created
+	Returns:		Nothing
+******************************************************************************/
+void CFlightRecorder::PruneLogFiles(int nNewest)
+{
+	DIR* pDirectory = opendir(m_strDirectory.c_str());
+	if (pDirectory == nullptr) return;
+
+	for (dirent* pEntry = readdir(pDirectory); pEntry != nullptr; pEntry = readdir(pDirectory))
+	{
+		int nIndex;
+		if ((sscanf(pEntry->d_name, "flight_%d.bin", &nIndex) == 1) && (nIndex <= nNewest - nFlightRecorderMaxFiles))
+		{
+			unlink((m_strDirectory + "/" + pEntry->d_name).c_str());
+		}
+	}
+	closedir(pDirectory);
+}
+
+/******************************************************************************
+	Description:	Unmap and close the log file
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CFlightRecorder::CloseLogFile()
+{
+	if (m_pHeader != nullptr)
+	{
+		msync(m_pHeader, m_nMappedSize, MS_SYNC);
+		munmap(m_pHeader, m_nMappedSize);
+	}
+	if (m_nFile >= 0) close(m_nFile);
+
+	m_pHeader	= nullptr;
+	m_pRecords	= nullptr;
+	m_nFile		= -1;
+}
+
+/******************************************************************************
+	Description:	Writer thread, drains the ring a few times a second at the
+					lowest scheduling priority and swaps files when asked
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CFlightRecorder::WriterThread()
+{
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+
+	while (m_bRunning)
+	{
+		Drain();
+		if (m_bRotate.exchange(false))
+		{
+			// Records queued from here on go to the new file, if it can't be opened they're counted as dropped.
+			CloseLogFile();
+			OpenLogFile();
+		}
+		if (m_pHeader != nullptr) msync(m_pHeader, m_nMappedSize, MS_ASYNC);
+		this_thread::sleep_for(chrono::milliseconds(250));
+	}
+}
+
+/******************************************************************************
+	Description:	Copy every pending record from the ring into the file
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CFlightRecorder::Drain()
+{
+	const unsigned int nHead = m_nHead.load(memory_order_acquire);
+	unsigned int nTail = m_nTail.load(memory_order_relaxed);
+	for (; nTail != nHead; nTail++)
+	{
+		// Once the file is full we keep the start of the period and count the rest.
+		if ((m_pHeader == nullptr) || (m_pHeader->m_nCount >= nFlightRecorderFileRecords))
+		{
+			m_nDropped.fetch_add(1, memory_order_relaxed);
+			continue;
+		}
+		m_pRecords[m_pHeader->m_nCount] = m_aRing[nTail & (nFlightRecorderRingSize - 1)];
+		m_pHeader->m_nCount++;
+	}
+	m_nTail.store(nTail, memory_order_release);
+	if (m_pHeader != nullptr) m_pHeader->m_nDropped = m_nDropped.load(memory_order_relaxed);
+}
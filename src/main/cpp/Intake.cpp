@@ -9,15 +9,23 @@
 
 /******************************************************************************
 	Description:	CIntake constructor, init local variables/classes
-	Arguments:		None
+	Arguments:		const sIntakeSensors* pSensors - Snapshot entry for this intake
+					CCommandCache* pCommandCache
+					int nIntakeMotor1, int nIntakeDownLimitSwitch,
+					int nIntakeUpLimitSwitch, int nDeployController,
+					bool bIntakePosition
 	Derived from:	Nothing
 ******************************************************************************/
-CIntake::CIntake(int nIntakeMotor1, int nIntakeDownLimitSwitch, int nIntakeUpLimitSwitch, int nDeployController, bool bIntakePosition = false)
+CIntake::CIntake(const sIntakeSensors* pSensors, CCommandCache* pCommandCache, int nIntakeMotor1, int nIntakeDownLimitSwitch, int nIntakeUpLimitSwitch, int nDeployController, bool bIntakePosition = false)
 {
 	m_pIntakeMotor1					= new CANSparkMax(nIntakeMotor1, CANSparkMaxLowLevel::MotorType::kBrushless);
 	m_pIntakeDeployMotorController1	= new WPI_TalonSRX(nDeployController);
 	m_pLimitSwitchDown				= new DigitalInput(nIntakeDownLimitSwitch);
 	m_pLimitSwitchUp				= new DigitalInput(nIntakeUpLimitSwitch);
+	m_pSensors						= pSensors;
+	m_pCommandCache					= pCommandCache;
+	m_nIntakeCommand				= m_pCommandCache->Register();
+	m_nDeployCommand				= m_pCommandCache->Register();
 	m_pIntakeDeployMotorController1->SetInverted(bIntakePosition);
 	m_pIntakeMotor1->SetInverted(bIntakePosition);
 }
@@ -65,8 +73,8 @@ void CIntake::Init()
 ******************************************************************************/
 bool CIntake::IsGoalPressed()
 {
-	if (m_bGoal)	{	return !m_pLimitSwitchUp->Get();	}
-	else			{	return !m_pLimitSwitchDown->Get();	}
+	if (m_bGoal)	{	return m_pSensors->m_bUpPressed;	}
+	else			{	return m_pSensors->m_bDownPressed;	}
 }
 
 /******************************************************************************
@@ -76,8 +84,8 @@ bool CIntake::IsGoalPressed()
 ******************************************************************************/
 void CIntake::ToggleIntake()
 {
-	if (m_bGoal)	{	m_pIntakeDeployMotorController1->Set(-0.350);	}		// Reverse to take it up
-	else			{	m_pIntakeDeployMotorController1->Set(0.350);	}		// Forward to take it down
+	if (m_bGoal)	{	m_pCommandCache->Set(m_nDeployCommand, m_pIntakeDeployMotorController1, ControlMode::PercentOutput, -0.350);	}		// Reverse to take it up
+	else			{	m_pCommandCache->Set(m_nDeployCommand, m_pIntakeDeployMotorController1, ControlMode::PercentOutput, 0.350);	}		// Forward to take it down
 }
 
 /******************************************************************************
@@ -93,7 +101,7 @@ void CIntake::StopDeploy()
 	if(m_bGoal) idleAmount = -0.05;
 	else idleAmount = 0.095;
 
-	m_pIntakeDeployMotorController1->Set(idleAmount);
+	m_pCommandCache->Set(m_nDeployCommand, m_pIntakeDeployMotorController1, ControlMode::PercentOutput, idleAmount);
 }
 
 /******************************************************************************
@@ -104,7 +112,7 @@ void CIntake::StopDeploy()
 void CIntake::StartIntake(bool bSafe)
 {
 	if (IsGoalPressed() && !m_bGoal) {
-		m_pIntakeMotor1->Set(0.700);
+		m_pCommandCache->Set(m_nIntakeCommand, m_pIntakeMotor1, 0.700);
 		m_bIntakeOn = true;
 	}
 }
@@ -116,7 +124,7 @@ void CIntake::StartIntake(bool bSafe)
 ******************************************************************************/
 void CIntake::StopIntake()
 {
-	m_pIntakeMotor1->Set(0.000);
+	m_pCommandCache->Set(m_nIntakeCommand, m_pIntakeMotor1, 0.000);
 	m_bIntakeOn = false;
 }
 
@@ -126,8 +134,8 @@ void CIntake::StopIntake()
 	Returns:		Nothing
 ******************************************************************************/
 void CIntake::MoveIntake(bool bUp) {
-	if(bUp) m_pIntakeDeployMotorController1->Set(-0.500);
-	else    m_pIntakeDeployMotorController1->Set(0.650);
+	if(bUp) m_pCommandCache->Set(m_nDeployCommand, m_pIntakeDeployMotorController1, ControlMode::PercentOutput, -0.500);
+	else    m_pCommandCache->Set(m_nDeployCommand, m_pIntakeDeployMotorController1, ControlMode::PercentOutput, 0.650);
 }
 
 /******************************************************************************
@@ -136,6 +144,29 @@ void CIntake::MoveIntake(bool bUp) {
 	Returns:		Nothing
 ******************************************************************************/
 bool CIntake::GetLimitSwitchState(bool bUp) {
-	if(bUp) return !m_pLimitSwitchUp->Get();
-	else    return !m_pLimitSwitchDown->Get();
+	if(bUp) return m_pSensors->m_bUpPressed;
+	else    return m_pSensors->m_bDownPressed;
+}
+
+/******************************************************************************
+	Description:	Reads both limit switches into the loop's sensor snapshot
+	Arguments:		sIntakeSensors& Sensors
+	Returns:		Nothing
+******************************************************************************/
+void CIntake::ReadSensors(sIntakeSensors& Sensors)
+{
+	Sensors.m_bDownPressed	= !m_pLimitSwitchDown->Get();
+	Sensors.m_bUpPressed	= !m_pLimitSwitchUp->Get();
+}
+
+/******************************************************************************
+	Description:	Declare the CAN signals the intake reads. The limit switches
+					are on the roboRIO, so nothing is read from either motor.
+	Arguments:		CStatusFramePlanner* pPlanner
+	Returns:		Nothing
+******************************************************************************/
+void CIntake::ConfigureStatusFrames(CStatusFramePlanner* pPlanner)
+{
+	pPlanner->AddSpark(m_pIntakeMotor1);
+	pPlanner->AddTalon(m_pIntakeDeployMotorController1, eCanTalonSRX);
 }
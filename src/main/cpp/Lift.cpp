@@ -6,17 +6,20 @@
 ******************************************************************************/
 
 #include "Lift.h"
+#include "LoopProfiler.h"
 ///////////////////////////////////////////////////////////////////////////////
 
 /******************************************************************************
 	Description:	CLift constructor - init local variables/classes
-	Arguments:		None
+	Arguments:		CCommandCache* pCommandCache
 	Returns:		Nothing
 ******************************************************************************/
-CLift::CLift()
+CLift::CLift(CCommandCache* pCommandCache)
 {
 	m_pLiftMotor1	= new WPI_TalonFX(nLiftMotor1);
 	m_pLiftMotor2	= new WPI_TalonFX(nLiftMotor2);
+	m_pCommandCache	= pCommandCache;
+	m_nLiftCommand	= m_pCommandCache->Register();
 }
 
 /******************************************************************************
@@ -34,7 +37,7 @@ CLift::~CLift()
 }
 
 void CLift::Tick() {
-	
+	PROFILE_SCOPE(eProfileLiftTick);
 }
 
 /******************************************************************************
@@ -73,7 +76,20 @@ void CLift::MoveArms(double dJoystickPosition)
 	if (fabs(dPosition) < 0.100) dPosition = 0.0;
 
 	// If the joystick is positive, drive the arms down
-	if(dPosition > 0.250) m_pLiftMotor1->Set(-0.100);
-	else if(dPosition < -0.250) m_pLiftMotor1->Set(0.100);
-	else m_pLiftMotor1->Set(0.000);
+	if(dPosition > 0.250) m_pCommandCache->Set(m_nLiftCommand, m_pLiftMotor1, ControlMode::PercentOutput, -0.100);
+	else if(dPosition < -0.250) m_pCommandCache->Set(m_nLiftCommand, m_pLiftMotor1, ControlMode::PercentOutput, 0.100);
+	else m_pCommandCache->Set(m_nLiftCommand, m_pLiftMotor1, ControlMode::PercentOutput, 0.000);
+}
+
+/******************************************************************************
+	Description:	Declare the CAN signals the lift reads. Nothing is read back,
+					but the second arm motor follows the first.
+	Arguments:		CStatusFramePlanner* pPlanner
+	Returns:		Nothing
+******************************************************************************/
+void CLift::ConfigureStatusFrames(CStatusFramePlanner* pPlanner)
+{
+	const int nDevice = pPlanner->AddTalon(m_pLiftMotor1, eCanTalonFX);
+	pPlanner->Require(nDevice, eSignalOutput, 10);
+	pPlanner->AddTalon(m_pLiftMotor2, eCanTalonFX);
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+/******************************************************************************
+	Description:	CLoopProfiler implementation
+	Class:			CLoopProfiler
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "LoopProfiler.h"
+
+#include <string>
+#include <frc/smartdashboard/SmartDashboard.h>
+
+using namespace frc;
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t CLoopProfiler::m_aBuckets[eProfileSiteCount][nProfileBucketCount]	= {};
+uint32_t CLoopProfiler::m_aCounts[eProfileSiteCount]						= {};
+uint32_t CLoopProfiler::m_aMax[eProfileSiteCount]							= {};
+
+// Dashboard names, in ProfileSite order.
+static const char* const s_apszSiteNames[eProfileSiteCount] = {
+	"Shooter Tick",
+	"Transfer UpdateLocations",
+	"Lift Tick",
+	"Drive Tick",
+	"Teleop Vision",
+	"Profiler Self Test"
+};
+
+/******************************************************************************
+	Description:	Add one execution time to a site's histogram
+	Arguments:		int nSite, uint32_t nNanoseconds
+	Returns:		Nothing
+******************************************************************************/
+void CLoopProfiler::Record(int nSite, uint32_t nNanoseconds)
+{
+	m_aBuckets[nSite][BucketIndex(nNanoseconds)]++;
+	m_aCounts[nSite]++;
+	if (nNanoseconds > m_aMax[nSite]) m_aMax[nSite] = nNanoseconds;
+}
+
+/******************************************************************************
+	Description:	Walk a site's histogram up to the requested percentile
+	Arguments:		int nSite, double dPercentile (0 - 100)
+	Returns:		double - Execution time in microseconds
+******************************************************************************/
+double CLoopProfiler::GetPercentile(int nSite, double dPercentile)
+{
+	if (m_aCounts[nSite] == 0) return 0.000;
+
+	const double dTarget = m_aCounts[nSite] * (dPercentile / 100.000);
+	uint32_t nSeen = 0;
+	for (int i = 0; i < nProfileBucketCount; i++)
+	{
+		nSeen += m_aBuckets[nSite][i];
+		if (nSeen >= dTarget && nSeen > 0) return BucketValue(i) / 1000.000;
+	}
+	return GetMax(nSite);
+}
+
+/******************************************************************************
+	Description:	Get a site's longest execution time
+	Arguments:		int nSite
+	Returns:		double - Execution time in microseconds
+******************************************************************************/
+double CLoopProfiler::GetMax(int nSite)
+{
+	return m_aMax[nSite] / 1000.000;
+}
+
+/******************************************************************************
+	Description:	Time a run of empty scoped timers to find the cost of the
+					instrumentation itself
+	Arguments:		int nIterations
+	Returns:		double - Cost of one scoped timer in nanoseconds
+******************************************************************************/
+double CLoopProfiler::MeasureOverhead(int nIterations)
+{
+	const auto tStart = chrono::steady_clock::now();
+	for (int i = 0; i < nIterations; i++)
+	{
+		CScopedTimer Timer(eProfileSelfTest);
+	}
+	const auto tEnd = chrono::steady_clock::now();
+
+	Reset(eProfileSelfTest);
+	return chrono::duration<double, nano>(tEnd - tStart).count() / nIterations;
+}
+
+/******************************************************************************
+	Description:	Put p50/p99/max for every site on the SmartDashboard
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CLoopProfiler::Publish()
+{
+	for (int i = 0; i < eProfileSiteCount; i++)
+	{
+		if (i == eProfileSelfTest) continue;
+
+		const string strName = string("Profile/") + s_apszSiteNames[i];
+		SmartDashboard::PutNumber(strName + " p50 (us)", GetPercentile(i, 50.000));
+		SmartDashboard::PutNumber(strName + " p99 (us)", GetPercentile(i, 99.000));
+		SmartDashboard::PutNumber(strName + " max (us)", GetMax(i));
+		SmartDashboard::PutNumber(strName + " count", m_aCounts[i]);
+	}
+}
+
+/******************************************************************************
+	Description:	Clear a site's histogram
+	Arguments:		int nSite
+	Returns:		Nothing
+******************************************************************************/
+void CLoopProfiler::Reset(int nSite)
+{
+	for (int i = 0; i < nProfileBucketCount; i++) m_aBuckets[nSite][i] = 0;
+	m_aCounts[nSite]	= 0;
+	m_aMax[nSite]		= 0;
+}
+
+/******************************************************************************
+	Description:	Map a time onto its log-linear bucket
+	Arguments:		uint32_t nNanoseconds
+	Returns:		int - Bucket index
+******************************************************************************/
+int CLoopProfiler::BucketIndex(uint32_t nNanoseconds)
+{
+	if (nNanoseconds < (1u << nProfileSubBucketBits)) return nNanoseconds;
+
+	const int nShift = (31 - __builtin_clz(nNanoseconds)) - nProfileSubBucketBits;
+	return ((nShift + 1) << nProfileSubBucketBits) + (int)((nNanoseconds >> nShift) - (1u << nProfileSubBucketBits));
+}
+
+/******************************************************************************
+	Description:	Lowest time that lands in a bucket
+	Arguments:		int nIndex
+	Returns:		uint32_t - Nanoseconds
+******************************************************************************/
+uint32_t CLoopProfiler::BucketValue(int nIndex)
+{
+	if (nIndex < (1 << nProfileSubBucketBits)) return nIndex;
+
+	const int nShift = (nIndex >> nProfileSubBucketBits) - 1;
+	const uint32_t nMantissa = (nIndex & ((1 << nProfileSubBucketBits) - 1)) + (1u << nProfileSubBucketBits);
+	return nMantissa << nShift;
+}
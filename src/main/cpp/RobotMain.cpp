@@ -5,11 +5,14 @@
 ******************************************************************************/
 
 #include "RobotMain.h"
+#include "LoopProfiler.h"
 
 #include <fmt/core.h>
 #include <frc/smartdashboard/SmartDashboard.h>
 #include <frc/DriverStation.h>
 #include <wpi/StringExtras.h>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -23,19 +26,38 @@ using namespace std;
 ******************************************************************************/
 CRobotMain::CRobotMain()
 {
+	m_pTelemetry				= new CTelemetry();
+	m_pCommandCache				= new CCommandCache(m_pTelemetry);
 	m_pDriveController			= new Joystick(0);
 	m_pAuxController			= new Joystick(1);
 	m_pTimer					= new Timer();
-	m_pDrive					= new CDrive(m_pDriveController);
+	m_pDrive					= new CDrive(m_pDriveController, m_pTelemetry, &m_Snapshot);
 	m_pAutoChooser				= new SendableChooser<Paths>();
-	m_pLift						= new CLift();
-	m_pBackIntake				= new CIntake(nIntakeMotor2, nBackIntakeDownLS, nBackIntakeUpLS, nIntakeDeployMotor2, false);
-	m_pShooter					= new CShooter();
+	m_pLift						= new CLift(m_pCommandCache);
+	m_pBackIntake				= new CIntake(&m_Snapshot.m_BackIntake, m_pCommandCache, nIntakeMotor2, nBackIntakeDownLS, nBackIntakeUpLS, nIntakeDeployMotor2, false);
+	m_pShooter					= new CShooter(m_pTelemetry, m_pCommandCache);
 	m_nAutoState				= eAutoStopped;
 	m_dStartTime				= 0.0;
 	m_nPreviousState			= eTeleopStopped;
-	m_pPrevVisionPacket         = new CVisionPacket();
-	m_pTransfer					= new CTransfer();
+	m_pVisionIngest				= new CVisionIngest(m_pTelemetry);
+	m_pTargetTracker			= new CTargetTracker(m_pTelemetry);
+	m_pFieldMap					= new CFieldMap(m_pTelemetry);
+	m_pTransfer					= new CTransfer(&m_Snapshot, m_pCommandCache);
+	m_pFlightRecorder			= new CFlightRecorder();
+	m_nTeleopState				= eTeleopStopped;
+
+	m_pControlTiers				= new CControlTiers(this, m_pTelemetry);
+	m_pStatusFramePlanner		= new CStatusFramePlanner();
+	m_pAutoSequencer			= new CAutoSequencer(m_pDrive, m_pShooter, m_pTransfer, m_pBackIntake, m_pTelemetry);
+	m_pRobotSim					= nullptr;
+	m_pSimScenario				= nullptr;
+
+	// Sensor to motor loops run on the fast tier, everything else once per loop.
+	m_pControlTiers->Register(eTierFast, [this] { m_pDrive->FastTick(); });
+	m_pControlTiers->Register(eTierFast, [this] { m_pShooter->FastTick(); });
+	m_pControlTiers->Register(eTierSlow, [this] { m_pShooter->Tick(); });
+	m_pControlTiers->Register(eTierSlow, [this] { m_pTransfer->UpdateLocations(); });
+	m_pControlTiers->Register(eTierSlow, [this] { m_pLift->Tick(); });
 }
 
 /******************************************************************************
@@ -52,8 +74,19 @@ CRobotMain::~CRobotMain()
 	delete m_pLift;
 	delete m_pAutoChooser;
 	delete m_pBackIntake;
-	delete m_pPrevVisionPacket;
+	delete m_pVisionIngest;
+	delete m_pTargetTracker;
+	delete m_pFieldMap;
 	delete m_pTransfer;
+	delete m_pShooter;
+	delete m_pFlightRecorder;
+	delete m_pControlTiers;
+	delete m_pStatusFramePlanner;
+	delete m_pAutoSequencer;
+	delete m_pCommandCache;
+	delete m_pSimScenario;
+	delete m_pRobotSim;
+	delete m_pTelemetry;
 
 	m_pDriveController	= nullptr;
 	m_pAuxController	= nullptr;
@@ -62,8 +95,19 @@ CRobotMain::~CRobotMain()
 	m_pLift				= nullptr;
 	m_pAutoChooser		= nullptr;
 	m_pBackIntake		= nullptr;
-	m_pPrevVisionPacket = nullptr;
+	m_pVisionIngest		= nullptr;
+	m_pTargetTracker	= nullptr;
+	m_pFieldMap			= nullptr;
 	m_pTransfer			= nullptr;
+	m_pShooter			= nullptr;
+	m_pFlightRecorder	= nullptr;
+	m_pControlTiers		= nullptr;
+	m_pStatusFramePlanner	= nullptr;
+	m_pAutoSequencer	= nullptr;
+	m_pCommandCache		= nullptr;
+	m_pSimScenario		= nullptr;
+	m_pRobotSim			= nullptr;
+	m_pTelemetry		= nullptr;
 }
 
 /******************************************************************************
@@ -76,6 +120,29 @@ void CRobotMain::RobotInit()
 	m_pDrive->Init();
 	m_pTransfer->Init();
 
+	// Slow down every CAN status frame nothing reads and report the bus load.
+	m_pDrive->ConfigureStatusFrames(m_pStatusFramePlanner);
+	m_pShooter->ConfigureStatusFrames(m_pStatusFramePlanner);
+	m_pLift->ConfigureStatusFrames(m_pStatusFramePlanner);
+	m_pBackIntake->ConfigureStatusFrames(m_pStatusFramePlanner);
+	m_pTransfer->ConfigureStatusFrames(m_pStatusFramePlanner);
+	m_pStatusFramePlanner->Apply();
+	m_pStatusFramePlanner->Publish();
+
+	// Load every autonomous trajectory and routine now so AutonomousInit never touches the disk.
+	m_pDrive->PreloadTrajectories();
+	m_pAutoSequencer->Load();
+	m_pShooter->LoadShotTable();
+
+	// Start receiving vision packets in the background.
+	m_pVisionIngest->Start();
+
+	// Start the flight recorder, the robot still runs without it if the log can't be opened. Off
+	// the roboRIO it only runs when FLIGHT_RECORDER_DIR asks, so simulation runs leave no logs.
+	const char* pszLogDirectory = getenv("FLIGHT_RECORDER_DIR");
+	if ((pszLogDirectory == nullptr) && RobotBase::IsReal()) pszLogDirectory = pszFlightRecorderDirectory;
+	if ((pszLogDirectory != nullptr) && !m_pFlightRecorder->Start(pszLogDirectory)) DriverStation::ReportWarning("Flight recorder could not open a log file");
+
 	// Setup autonomous chooser.
 	m_pAutoChooser->SetDefaultOption("Autonomous Idle", eAutoIdle);
 	m_pAutoChooser->AddOption("Advancement", eAdvancement1);
@@ -88,6 +155,18 @@ void CRobotMain::RobotInit()
 	SmartDashboard::PutData(m_pAutoChooser);
 
 	SmartDashboard::PutBoolean("bTeleopVision", false);
+
+#ifdef ENABLE_LOOP_PROFILER
+	// Report what the loop profiler itself costs per instrumented site.
+	SmartDashboard::PutNumber("Profile/Timer Overhead (ns)", CLoopProfiler::MeasureOverhead(10000));
+#endif
+
+	// Register dashboard values.
+	m_nVerticalInfraredHandle	= m_pTelemetry->RegisterBoolean("Vertical Transfer Infrared");
+	m_nBackInfraredHandle		= m_pTelemetry->RegisterBoolean("Back Transfer Infrared");
+	m_nBackDownLimitHandle		= m_pTelemetry->RegisterBoolean("Back-Down Limit Switch");
+	m_nBackUpLimitHandle		= m_pTelemetry->RegisterBoolean("Back-Up Limit Switch");
+	m_nRecordTimeHandle			= m_pTelemetry->RegisterNumber("Flight Recorder Record Time (us)", 0.100);
 	m_pTimer->Start();
 }
 
@@ -98,20 +177,96 @@ void CRobotMain::RobotInit()
 ******************************************************************************/
 void CRobotMain::RobotPeriodic()
 {
-	// Tick the shooter
-	m_pShooter->Tick();
+	// Keep the shot speed matched to the hub distance whenever the hub is tracked, the fixed speed otherwise.
+	const sTargetTrack* pHub = m_pTargetTracker->GetBest(eHub);
+	if (pHub != nullptr) m_pShooter->SetHubDistance(pHub->m_dDepth);
+	else m_pShooter->ClearHubDistance();
 
-	// Tick the transfer system
-	m_pTransfer->UpdateLocations();
-
-	// Tick the climber system
-	m_pLift->Tick();
+	// Tick the shooter, transfer and climber systems
+	m_pControlTiers->RunSlowTier();
 
 	// Update SmartDashboard for easy checking.
-	SmartDashboard::PutBoolean("Vertical Transfer Infrared", m_pTransfer->m_aBallLocations[0]);
-	SmartDashboard::PutBoolean("Back Transfer Infrared", m_pTransfer->m_aBallLocations[1]);
-	SmartDashboard::PutBoolean("Back-Down Limit Switch", m_pBackIntake->GetLimitSwitchState(false));
-	SmartDashboard::PutBoolean("Back-Up Limit Switch", m_pBackIntake->GetLimitSwitchState(true));
+	m_pTelemetry->SetBoolean(m_nVerticalInfraredHandle, m_pTransfer->m_aBallLocations[0]);
+	m_pTelemetry->SetBoolean(m_nBackInfraredHandle, m_pTransfer->m_aBallLocations[1]);
+	m_pTelemetry->SetBoolean(m_nBackDownLimitHandle, m_Snapshot.m_BackIntake.m_bDownPressed);
+	m_pTelemetry->SetBoolean(m_nBackUpLimitHandle, m_Snapshot.m_BackIntake.m_bUpPressed);
+	m_pVisionIngest->PublishStatistics();
+	m_pTargetTracker->Publish();
+	m_pFieldMap->Publish(m_Snapshot.m_dTimestamp);
+	m_pControlTiers->PublishStatistics();
+	m_pCommandCache->Publish();
+
+	// Snapshot this loop for the flight recorder
+	RecordFlight();
+
+	// Publish everything that changed this loop in one pass.
+	m_pTelemetry->Flush();
+}
+
+/******************************************************************************
+    Description:	Read every sensor once into m_Snapshot. Called first thing
+					in each mode's periodic function, TimedRobot runs those
+					before RobotPeriodic, so the whole loop sees one snapshot.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotMain::ReadSensors()
+{
+	m_Snapshot.m_dTimestamp			= (double)Timer::GetFPGATimestamp();
+	m_pCommandCache->SetTime(m_Snapshot.m_dTimestamp);
+	m_pDrive->ReadSensors(m_Snapshot);
+	m_Snapshot.m_dFlywheelVelocity	= m_pShooter->m_dFlywheelVelocity;
+	m_pBackIntake->ReadSensors(m_Snapshot.m_BackIntake);
+	m_pTransfer->ReadSensors(m_Snapshot);
+
+	// Fold any new vision frame into the target tracks and the field map.
+	const CVisionPacket* pVisionPacket = m_pVisionIngest->GetLatestPacket();
+	if (pVisionPacket != nullptr)
+	{
+		m_pTargetTracker->Update(pVisionPacket, m_pDrive->GetHeadingAt(pVisionPacket->m_dTimestamp));
+		m_pFieldMap->Update(pVisionPacket, m_pDrive->GetPoseAt(pVisionPacket->m_dTimestamp));
+	}
+	// Frames may have stopped coming, so age the tracks out on the loop's clock too.
+	m_pTargetTracker->Expire(m_Snapshot.m_dTimestamp);
+	m_pFieldMap->ClearFootprint(m_pDrive->GetPose(), m_Snapshot.m_dTimestamp);
+}
+
+/******************************************************************************
+    Description:	Snapshot every subsystem's state into the flight recorder
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotMain::RecordFlight()
+{
+	const auto tStart = chrono::steady_clock::now();
+
+	sFlightRecord Record;
+	Record.m_dTimestamp			= m_Snapshot.m_dTimestamp;
+	Record.m_fLeftVoltage		= m_Snapshot.m_dLeftVoltage;
+	Record.m_fRightVoltage		= m_Snapshot.m_dRightVoltage;
+	Record.m_fLeftVelocity		= m_Snapshot.m_dLeftVelocity;
+	Record.m_fRightVelocity		= m_Snapshot.m_dRightVelocity;
+	Record.m_fLeftPosition		= m_Snapshot.m_dLeftPosition;
+	Record.m_fRightPosition		= m_Snapshot.m_dRightPosition;
+	Record.m_fFlywheelVelocity	= m_Snapshot.m_dFlywheelVelocity;
+	Record.m_nAutoState			= m_nAutoState;
+	Record.m_nTeleopState		= m_nTeleopState;
+
+	if (IsDisabled())			Record.m_nMode = eModeDisabled;
+	else if (IsAutonomous())	Record.m_nMode = eModeAutonomous;
+	else if (IsTest())			Record.m_nMode = eModeTest;
+	else						Record.m_nMode = eModeTeleop;
+
+	Record.m_nFlags = 0;
+	if (m_pTransfer->m_aBallLocations[0])			Record.m_nFlags |= eVerticalBall;
+	if (m_pTransfer->m_aBallLocations[1])			Record.m_nFlags |= eBackBall;
+	if (m_Snapshot.m_BackIntake.m_bDownPressed)		Record.m_nFlags |= eIntakeDown;
+	if (m_Snapshot.m_BackIntake.m_bUpPressed)		Record.m_nFlags |= eIntakeUp;
+
+	m_pFlightRecorder->Record(Record);
+
+	const auto tEnd = chrono::steady_clock::now();
+	m_pTelemetry->SetNumber(m_nRecordTimeHandle, chrono::duration<double, micro>(tEnd - tStart).count());
 }
 
 /******************************************************************************
@@ -121,8 +276,15 @@ void CRobotMain::RobotPeriodic()
 ******************************************************************************/
 void CRobotMain::AutonomousInit()
 {
-	// Init Drive and disable joystick
+	// Always send the first command of the new mode, whatever the cache last saw.
+	m_pCommandCache->InvalidateAll();
+	// Each enabled period gets its own log file, however long the robot sat disabled first.
+	m_pFlightRecorder->Rotate();
+
+	// Init Drive and disable joystick, zeroing odometry moves every track and mapped cargo.
 	m_pDrive->Init();
+	m_pTargetTracker->Reset();
+	m_pFieldMap->Reset();
 	m_pDrive->SetDriveSafety(false);
 	m_pDrive->SetJoystickControl(false);
 
@@ -131,13 +293,23 @@ void CRobotMain::AutonomousInit()
 	m_pShooter->Init();
 	m_pShooter->StartFlywheelShot();
 	m_pTransfer->Init();
+	m_pControlTiers->ResetStatistics();
 
 	// Record start time
 	m_dStartTime = (double)m_pTimer->Get();
 
-	// Get selected option and switch m_nAutoState based on that
-	m_nAutoState = m_pAutoChooser->GetSelected();
+	// Get selected option and switch m_nAutoState based on that, a headless sim run picks its own
+	m_nAutoState = (m_pSimScenario != nullptr) ? m_pSimScenario->GetPath() : m_pAutoChooser->GetSelected();
 	m_pDrive->SetTrajectory(m_nAutoState);
+
+	// Paths with a routine in deploy/autos run from the sequencer, the rest from the switch in AutonomousPeriodic.
+	// A routine that failed to load has no fallback, so hold the robot still rather than guess.
+	if (!m_pAutoSequencer->Start(m_nAutoState) && (CAutoSequencer::GetRoutineName(m_nAutoState) != nullptr))
+	{
+		DriverStation::ReportError(fmt::format("Auto routine {} is not loaded, holding the robot stopped", CAutoSequencer::GetRoutineName(m_nAutoState)));
+		m_pShooter->Stop();
+		m_nAutoState = eAutoStopped;
+	}
 	
 	if(m_nAutoState == eTerminator) {
 		m_pBackIntake->ToggleIntake();
@@ -151,8 +323,16 @@ void CRobotMain::AutonomousInit()
 ******************************************************************************/
 void CRobotMain::AutonomousPeriodic() 
 {
+	ReadSensors();
+
 	double dElapsed = ((double)m_pTimer->Get() - m_dStartTime);
 
+	if (m_pAutoSequencer->IsRunning())
+	{
+		m_pAutoSequencer->Tick(dElapsed);
+		return;
+	}
+
 	switch (m_nAutoState) 
 	{
 		// Force stop everything
@@ -168,148 +348,12 @@ void CRobotMain::AutonomousPeriodic()
 				case eAdvancement1:
 					m_nAutoState = eAdvancement2;
 					break;
-				case eTestPath:
-					m_nAutoState = eAutoStopped;
-					break;
 				default:
 					m_nAutoState = eAutoIdle;
 					break;
 			}
 			break;
 		
-		// Test Path
-		case eTestPath:
-			m_pDrive->FollowTrajectory();
-			if (m_pDrive->IsTrajectoryFinished()) 
-			{
-				m_nPreviousState = eTestPath;
-				m_nAutoState = eAutoIdle;
-			}
-			break;
-
-		// Dumb Taxi
-		case eDumbTaxi:
-			if(dElapsed < 1.250) 
-				m_pDrive->SetDriveSpeeds(-6.000, -6.000);
-			else 
-				m_nAutoState = eAutoStopped;
-			break;
-
-		case eTaxiShot:
-			m_pShooter->StartFlywheelShot();
-
-			// Drive backwards for 0.5s
-			if(dElapsed < 1.00) {
-				m_pDrive->SetDriveSpeeds(-3.000, -3.000);
-			}
-			// Rev up the shooter for shooting
-			else {
-				m_pDrive->ForceStop();
-
-				bool bShoot = ((double)m_pTimer->Get() - m_dStartTime) > 4.5;
-				if(m_pShooter->m_bShooterFullSpeed || bShoot) {
-					m_pTransfer->StartVerticalShot();
-				}
-
-				// If we don't have a ball in the vertical anymore, shut off the shooter.
-				if(!m_pTransfer->m_aBallLocations[0]) {
-					m_pShooter->IdleStop();
-					m_pTransfer->StopVertical();
-					m_nAutoState = eAutoStopped;
-				}
-			}
-			break;
-		case eTaxi2Shot:
-			m_pShooter->StartFlywheelShot();
-
-			// Pull the intake down and then start it			
-			if(dElapsed < 0.125) {
-				m_pBackIntake->MoveIntake(false);
-				m_pTransfer->StopVertical();
-			}
-
-			if(m_pBackIntake->GetLimitSwitchState(false)) {
-				m_pBackIntake->StartIntake();
-				m_pBackIntake->StopDeploy();
-				if(!m_pTransfer->m_aBallLocations[1]) m_pTransfer->StartBack();
-			}
-
-
-			if(dElapsed < 6.50 && m_pTransfer->m_aBallLocations[1]) m_pTransfer->StopBack();
-
-			// Drive backwards for 0.5s
-			if(dElapsed < 1.00) {
-				m_pDrive->SetDriveSpeeds(-3.000, -3.000);
-			}
-			// Rev up the shooter for shooting
-			else {
-				m_pDrive->ForceStop();
-
-				// Drive forward for .5s
-				if(dElapsed > 1.25) m_pDrive->SetDriveSpeeds(1.250, 1.250);
-				if(dElapsed > 1.50) m_pDrive->ForceStop();
-
-				if(m_pShooter->m_bShooterFullSpeed) {
-					if(dElapsed > 4.50) {
-						m_pTransfer->StartVerticalShot();
-					}
-
-					if(dElapsed < 6.50 && m_pTransfer->m_aBallLocations[0] && m_pTransfer->m_aBallLocations[1]) m_pTransfer->StopBack();
-					else if(dElapsed >= 6.50 && !m_pTransfer->m_aBallLocations[0]) m_pTransfer->StartBack();
-				}
-			}
-			break;
-		// Less Dumb Taxi
-		case eLessDumbTaxi1:
-			if( ((double)m_pTimer->Get() - m_dStartTime) < 0.750) {
-				// Drop the intake down and then start it.
-				m_pBackIntake->ToggleIntake();
-				m_pBackIntake->StartIntake();
-				// Drive backwards for a bit
-				m_pDrive->SetDriveSpeeds(-6.000, -6.000);
-				
-				// Start/Stop the back transfer depending on if we've picked up the ball already.
-				if(!m_pTransfer->m_aBallLocations[1]) m_pTransfer->StartBack();
-				else m_pTransfer->StopBack();
-			}
-			else {
-				m_nPreviousState = eLessDumbTaxi1;
-				m_nAutoState = eLessDumbTaxi2;
-				// Stop the intake to avoid picking up more than 2 balls
-				m_pBackIntake->StopIntake();
-			}
-			break;
-		case eLessDumbTaxi2:
-			if( ((double)m_pTimer->Get() - m_dStartTime) < 1.750) {
-				// Drive backwards more
-				m_pDrive->SetDriveSpeeds(-6.000, -6.000);
-			}
-			else {
-				m_nPreviousState = eLessDumbTaxi2;
-				m_nAutoState = eLessDumbTaxi3;
-			}
-			break;
-		case eLessDumbTaxi3:
-			if(!m_pShooter->m_bShooterFullSpeed && m_pTransfer->m_aBallLocations[0]) {
-				// Start the flywheel since the shooter isn't full speed yet.
-				m_pShooter->StartFlywheelShot();
-			}
-			// The flywheel has spun up to full speed, now we start the vertical transfer to feed the ball in.
-			if(m_pShooter->m_bShooterFullSpeed) {
-				m_pTransfer->StartVerticalShot();
-				if (!m_pTransfer->m_aBallLocations[0]) {
-					// Spin the vertical transfer to "full" speed just to make sure the back ball is ready.
-					m_pTransfer->StartVerticalShot();
-					// We need to feed the balls in the horizontal into the vertical and let them sit there.
-					m_pTransfer->StartBack();
-				}
-			}
-			// We don't have any balls in the robot, time to stop the autonomous.
-			if(!m_pTransfer->m_aBallLocations[0] && !m_pTransfer->m_aBallLocations[1]) {
-				m_nAutoState = eAutoStopped;
-			}
-			break;
-	
 		case eTerminator:
 			// Deploy the intake (similar logic to Teleop)
 			if (m_pBackIntake->IsGoalPressed())
@@ -320,83 +364,30 @@ void CRobotMain::AutonomousPeriodic()
 				m_pBackIntake->StopDeploy();
 				m_pBackIntake->m_bGoal = !m_pBackIntake->m_bGoal;
 			}
-			/*
-			// Get the vision packet from the coprocessor.
-			CVisionPacket* pVisionPacket = CVisionPacket::GetReceivedPacket();
-			if(pVisionPacket != nullptr) {
-				if(m_pPrevVisionPacket->m_nRandVal != pVisionPacket->m_nRandVal) {
-					pVisionPacket->ParseDetections();
-					DetectionClass kDetectClass = (DriverStation::GetAlliance() == DriverStation::Alliance::kBlue ? eBlueCargo : eRedCargo);
-					DetectionClass kIgnoreClass = (DriverStation::GetAlliance() == DriverStation::Alliance::kBlue ? eRedCargo  : eBlueCargo);
-					
-					// Get the amount of balls inside the robot
-					int iBallCount = 0;
-					for(int i = 0; i < 3; i++) {
-						if(m_pTransfer->m_aBallLocations[i]) iBallCount += 1;
-					}
-					bool bBallHunting = false;
-					for(int i = 0; i < pVisionPacket->m_nDetectionCount; i++) {
-						CVisionPacket::sObjectDetection* pObjDetection = pVisionPacket->m_pDetections[i];
-						
-						// Go ball hunting if we don't have 2 balls.
-						if(iBallCount < 2) {
-							// Check if we detected any balls (luckily the detection information is sorted by depth on the Pi)
-							if(pObjDetection->m_kClass == kDetectClass) {
-								double dTheta = (pObjDetection->m_nX - 160) * dAnglePerPixel;
-								const double dHalfWidthAngle = (pObjDetection->m_nWidth / 2) * dAnglePerPixel;
-
-								// Go forward and head towards the ball
-								if (-dHalfWidthAngle < dTheta && dTheta < dHalfWidthAngle) {
-									if(pVisionPacket->m_kDetectionLocation == DetectionLocation::eFrontCamera) 
-										m_pDrive->SetDriveSpeeds(6.000, 6.000); 
-									else if(pVisionPacket->m_kDetectionLocation == DetectionLocation::eBackCamera)
-										m_pDrive->SetDriveSpeeds(-6.000, -6.000);
-								}
-								// Turn to center the detected object
-								else {
-									dTheta = dTheta * (pVisionPacket->m_kDetectionLocation == DetectionLocation::eFrontCamera ? 1 : -1);
-									m_pDrive->TurnByAngle(dTheta);
-								}
-								bBallHunting = true;
-								break;
-							}
-						}
-						else if(iBallCount >= 2) {
-							// Stop the drive
-							m_pDrive->SetDriveSpeeds(0.000, 0.000);
-
-							// We've grabbed atleast 2 balls, now lets try and shoot them...
-							if(pObjDetection->m_kClass == DetectionClass::eHub) {
-								// TODO: Drive odometry to determine the side we are on of the hub.
-								const units::degree_t driveRotation = m_pDrive->m_pOdometry->GetPose().Rotation().Degrees();
-								
-								// We're in range
-								if(CTrajectoryConstants::IsInShootingRange(pObjDetection->m_nDepth)) {
-
-								}
-								// Move closer to the hub
-								else if(pObjDetection->m_nDepth < (CTrajectoryConstants::m_dAutoShootingDistance - CTrajectoryConstants::m_dAutoShootingRange)) {
-									if(pVisionPacket->m_kDetectionLocation == DetectionLocation::eFrontCamera) m_pDrive->SetDriveSpeeds(6.000, 6.000); 
-									else if(pVisionPacket->m_kDetectionLocation == DetectionLocation::eBackCamera) m_pDrive->SetDriveSpeeds(-6.000, -6.000);
-								}
-								// Move farther from the hub
-								else if(pObjDetection->m_nDepth > (CTrajectoryConstants::m_dAutoShootingDistance + CTrajectoryConstants::m_dAutoShootingRange)) {
-									if(pVisionPacket->m_kDetectionLocation == DetectionLocation::eFrontCamera) m_pDrive->SetDriveSpeeds(-6.000, -6.000); 
-									else if(pVisionPacket->m_kDetectionLocation == DetectionLocation::eBackCamera) m_pDrive->SetDriveSpeeds(6.000, 6.000);
-								}
-							}
-						}
-					}
-
-					// We aren't on the hunt for a ball *AND* we don't have 2 balls in yet.
-					// This means there's not a ball
-					if(iBallCount < 2 && !bBallHunting) {
-						// Spin 90deg in order to hopefully try and find a ball in either of the directions.
-						m_pDrive->TurnByAngle(90);
-					}
+
+			// Hunt cargo of our colour with the back intake. The field map remembers cargo either
+			// camera has seen, so it can still be found after it leaves view.
+			if (m_pTransfer->m_aBallLocations[0] && m_pTransfer->m_aBallLocations[1]) {
+				m_pDrive->SetDriveSpeeds(0.000, 0.000);
+			}
+			else {
+				const DetectionClass kCargoClass = (DriverStation::GetAlliance() == DriverStation::Alliance::kBlue ? eBlueCargo : eRedCargo);
+				const Pose2d Pose = m_pDrive->GetPose();
+				Translation2d Cargo;
+				if (!m_pFieldMap->FindNearest(kCargoClass, Pose.Translation(), m_Snapshot.m_dTimestamp, Cargo)) {
+					// Nothing mapped yet, turn slowly so the cameras sweep the field.
+					m_pDrive->SetDriveSpeeds(dHuntSearchVoltage, -dHuntSearchVoltage);
+				}
+				else {
+					// Point the back at the cargo, then reverse onto it. Pose angles are counter-clockwise, the gyro is clockwise.
+					const Translation2d Offset = Cargo - Pose.Translation();
+					const double dBackAngle = Pose.Rotation().Degrees().value() + 180.000;
+					const double dError = remainder((atan2(Offset.Y().value(), Offset.X().value()) * (180.000 / M_PI)) - dBackAngle, 360.000);
+					const bool bTurning = m_pDrive->IsAiming() ? !m_pDrive->IsAimSettled() : (fabs(dError) > dHuntHeadingTolerance);
+					if (bTurning) m_pDrive->AimAtHeading(m_Snapshot.m_dHeading - dError);
+					else m_pDrive->SetDriveSpeeds(-dHuntReverseVoltage, -dHuntReverseVoltage);
 				}
 			}
-			*/
 			break;
 	}
 }
@@ -408,7 +399,11 @@ void CRobotMain::AutonomousPeriodic()
 ******************************************************************************/
 void CRobotMain::TeleopInit()
 {
+	m_pCommandCache->InvalidateAll();
+	m_pFlightRecorder->Rotate();
 	m_pDrive->Init();
+	m_pTargetTracker->Reset();
+	m_pFieldMap->Reset();
 	m_pDrive->SetJoystickControl(true);
 	m_pBackIntake->Init();
 	m_pLift->Init();
@@ -416,6 +411,7 @@ void CRobotMain::TeleopInit()
 	m_pShooter->Init();
 	m_pShooter->StartFlywheelShot();
 	m_pTransfer->Init();
+	m_pControlTiers->ResetStatistics();
 }
 
 /******************************************************************************
@@ -425,6 +421,8 @@ void CRobotMain::TeleopInit()
 ******************************************************************************/
 void CRobotMain::TeleopPeriodic()
 {
+	ReadSensors();
+
 	/**************************************************************************
 	    Description:	Drive stop and Joystick handling
 	**************************************************************************/
@@ -512,33 +510,27 @@ void CRobotMain::TeleopPeriodic()
 	// Add a toggle for vision in teleop just to be safe.
 	if(SmartDashboard::GetBoolean("bTeleopVision", false))
 	{
-		CVisionPacket* pVisionPacket = CVisionPacket::GetReceivedPacket();
-		if(pVisionPacket != nullptr)
+		PROFILE_SCOPE(eProfileTeleopVision);
+
+		// For vision in teleop, we can try fine adjustments to the robot's angle to the hub. The hub's
+		// track is smoothed over several frames, so one bad detection can't swing the aim.
+		const sTargetTrack* pHubTrack = m_pTargetTracker->GetBest(eHub);
+		if(pHubTrack != nullptr)
 		{
-			if(m_pPrevVisionPacket->m_nRandVal != pVisionPacket->m_nRandVal)
+			// Aim where the track says the hub is now, not where it was in the last frame.
+			const double dBearing = CTargetTracker::PredictBearing(*pHubTrack, m_Snapshot.m_dTimestamp);
+			const double dTheta = dBearing - m_Snapshot.m_dHeading;
+			const double dHalfWidthAngle = (pHubTrack->m_dWidth / 2) * dAnglePerPixel;
+
+			// Lock the heading onto the hub, the drive holds it between frames. Once locked
+			// it follows the track, the driver's turn stick releases it.
+			if(m_pShooter->m_bShooterFullSpeed && (m_pDrive->IsAiming() || -dHalfWidthAngle > dTheta || dTheta > dHalfWidthAngle))
 			{
-				pVisionPacket->ParseDetections();
-				for(int i = 0; i < pVisionPacket->m_nDetectionCount; i++)
-				{
-					CVisionPacket::sObjectDetection* pObjDetection = pVisionPacket->m_pDetections[i];
-					
-					// For vision in teleop, we can try fine adjustments to the robot's angle to the hub...
-					if(pObjDetection->m_kClass == eHub)
-					{
-						const double dTheta = (pObjDetection->m_nX - 160) * dAnglePerPixel;
-						const double dHalfWidthAngle = (pObjDetection->m_nWidth / 2) * dAnglePerPixel;
-						
-						// Turn by however much we need to center the shooter (camera, really) onto the hub.
-						if(m_pShooter->m_bShooterFullSpeed && (-dHalfWidthAngle > dTheta || dTheta > dHalfWidthAngle))
-						{
-							m_pDrive->TurnByAngle(dTheta);
-							break;
-						}
-					}
-				}
+				m_pDrive->AimAtHeading(dBearing);
 			}
 		}
 	}
+	else m_pDrive->StopAim();
 }
 
 /******************************************************************************
@@ -550,6 +542,19 @@ void CRobotMain::DisabledInit()
 {
 	m_pDrive->SetJoystickControl(false);
 	m_pDrive->SetDriveSafety(true);
+	m_pDrive->StopFollowing();
+	m_pDrive->StopAim();
+	m_pAutoSequencer->Stop();
+
+	// Pick up any routine or shot table files changed since the last run.
+	m_pAutoSequencer->Load();
+	m_pShooter->LoadShotTable();
+
+#ifdef ENABLE_LOOP_PROFILER
+	// Publish the loop timing histograms from the period that just ended, then start the next one empty.
+	CLoopProfiler::Publish();
+	for (int i = 0; i < eProfileSiteCount; i++) CLoopProfiler::Reset(i);
+#endif
 }
 
 /******************************************************************************
@@ -559,7 +564,7 @@ void CRobotMain::DisabledInit()
 ******************************************************************************/
 void CRobotMain::DisabledPeriodic()
 {
-
+	ReadSensors();
 }
 
 /******************************************************************************
@@ -569,9 +574,17 @@ void CRobotMain::DisabledPeriodic()
 ******************************************************************************/
 void CRobotMain::TestInit()
 {
+	m_pCommandCache->InvalidateAll();
+	m_pFlightRecorder->Rotate();
 	m_pDrive->Init();
+	m_pTargetTracker->Reset();
+	m_pFieldMap->Reset();
 	m_pDrive->SetJoystickControl(true);
-	m_pPrevVisionPacket = new CVisionPacket();
+
+	// Compare the JSON and binary trajectory loaders on the deployed paths.
+	CTrajectoryConstants::BenchmarkLoaders();
+	// Compare the per detection and batch vision decoders.
+	CDetectionBatch::Benchmark();
 }
 
 /******************************************************************************
@@ -581,62 +594,44 @@ void CRobotMain::TestInit()
 ******************************************************************************/
 void CRobotMain::TestPeriodic()
 {
-	/**************************************************************************
-	    Description:	Vision processing and ball trackings
-	**************************************************************************/
-	CVisionPacket* pVisionPacket = CVisionPacket::GetReceivedPacket();
-	if(pVisionPacket != nullptr) {
-		if(m_pPrevVisionPacket->m_nRandVal != pVisionPacket->m_nRandVal) {
-			pVisionPacket->ParseDetections();
-			// DetectionClass kBallClass = (DriverStation::GetAlliance() == DriverStation::Alliance::kBlue ? eBlueCargo : eRedCargo);
-		}
-		else m_pDrive->Tick();
-	}
-	else m_pDrive->Tick();
+	ReadSensors();
+	m_pDrive->Tick();
+}
 
-	/*
-	// If the processed_vision is empty, then the vision code isn't running (?);
-	// Button A on drive controller must also have been pressed
-	if (!processed_vision.empty() && m_pDriveController->GetRawButtonPressed(eButtonA))
-	{
-		const char* pVisionPacketArr = processed_vision.c_str();
-		CVisionPacket* pVisionPacket = new CVisionPacket(pVisionPacketArr, processed_vision.length());
-
-		if(pVisionPacket->m_nRandVal != 0xFF) {
-			if(m_pPrevVisionPacket->m_nRandVal != pVisionPacket->m_nRandVal) {
-				// Parse out the detections now that we know that it's a different packet 
-				pVisionPacket->ParseDetections();
-				DetectionClass kDetectClass = (DriverStation::GetAlliance() == DriverStation::Alliance::kBlue ? eBlueCargo : eRedCargo);
-				
-				// ostringstream oss;
-				for(int i = 0; i < pVisionPacket->m_nDetectionCount; i++) {
-					CVisionPacket::sObjectDetection* pObjDetection = pVisionPacket->m_pDetections[i];
-					// oss << "[" << i << "] - Conf: " << std::hex << (int)pObjDetection->m_nConfidence;
-					// oss << " - Depth: " << std::hex << (int)pObjDetection->m_nDepth << " ";	5
-					if(pObjDetection->m_kClass == kDetectClass) {
-						const double dTheta = (pObjDetection->m_nX - 160) * dAnglePerPixel;
-						const double dHalfWidthAngle = (pObjDetection->m_nWidth / 2) * dAnglePerPixel;
-						// Go forward
-						if (-dHalfWidthAngle < dTheta && dTheta < dHalfWidthAngle) {
-							wpi::outs() << "Going forward...\r\n";
-							m_pDrive->GoForwardUntuned(); 
-						}
-						// Turn to center the detected object
-						else {
-							wpi::outs() << "Turning...\r\n";
-							m_pDrive->TurnByAngle(dTheta);
-						}
-					}
-				}
-				wpi::outs().flush();
+/******************************************************************************
+    Description:	Simulation initialization, builds the physics models once
+					every subsystem exists
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotMain::SimulationInit()
+{
+	m_pRobotSim = new CRobotSim(m_pDrive, m_pShooter, m_pTransfer, m_pBackIntake, m_pTelemetry);
 
-			} else m_pDrive->Tick();
-			m_pPrevVisionPacket = pVisionPacket;
-		}
-		else m_pDrive->Tick();
+	// Step the models at the fast tier's rate, offset half a period so each step lands between two ticks.
+	AddPeriodic([this] { m_pRobotSim->Tick(dFastTierPeriod); }, units::second_t(dFastTierPeriod), units::second_t(dFastTierPeriod / 2.000));
+
+	// A scenario from tools/sim_batch.py runs one autonomous and exits.
+	sSimScenario Scenario;
+	if (CSimScenario::FromEnvironment(Scenario))
+	{
+		m_pSimScenario = new CSimScenario(Scenario, m_pRobotSim, m_pDrive, m_pTargetTracker);
+		m_pSimScenario->Start();
 	}
-	else m_pDrive->Tick();
-	*/
+	// Otherwise run faster than real time if asked to.
+	else if (getenv("SIM_ACCELERATED") != nullptr) m_pRobotSim->StartAccelerated();
+}
+
+/******************************************************************************
+    Description:	Simulation 20ms periodic function, runs after the mode and
+					robot periodic functions. The models step on their own
+					callback, see SimulationInit().
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotMain::SimulationPeriodic()
+{
+	if ((m_pSimScenario != nullptr) && m_pSimScenario->Tick()) EndCompetition();
 }
 
 #ifndef RUNNING_FRC_TESTS
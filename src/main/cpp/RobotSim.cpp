@@ -0,0 +1,325 @@
+/******************************************************************************
+	Description:	CRobotSim implementation
+	Class:			CRobotSim
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "RobotSim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <frc/RobotController.h>
+#include <frc/simulation/BatterySim.h>
+#include <frc/simulation/RoboRioSim.h>
+#include <frc/simulation/SimHooks.h>
+#include <frc/system/plant/DCMotor.h>
+#include <units/impedance.h>
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CRobotSim constructor, init variables
+	Arguments:		CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer,
+					CIntake* pIntake, CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CRobotSim::CRobotSim(CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer, CIntake* pIntake, CTelemetry* pTelemetry)
+{
+	m_pDrive			= pDrive;
+	m_pShooter			= pShooter;
+	m_pTransfer			= pTransfer;
+	m_pIntake			= pIntake;
+	m_pTelemetry		= pTelemetry;
+
+	m_pDriveSim			= new sim::DifferentialDrivetrainSim(DCMotor::Falcon500(2), dSimDriveGearing, kilogram_square_meter_t(dSimDriveInertia), kilogram_t(dSimDriveMass), inch_t(dSimDriveWheelRadius), inch_t(dSimDriveTrackWidth));
+	m_pFlywheelSim		= new sim::FlywheelSim(DCMotor::Falcon500(2), 1.000, kilogram_square_meter_t(dSimFlywheelInertia));
+	m_pBackInfraredSim	= new sim::DIOSim(nBackTransferInfrared);
+	m_pTopInfraredSim	= new sim::DIOSim(nTopTransferInfrared);
+	m_pIntakeDownSim	= new sim::DIOSim(nBackIntakeDownLS);
+	m_pIntakeUpSim		= new sim::DIOSim(nBackIntakeUpLS);
+	m_bAccelerated		= false;
+	m_Random.seed(m_Perturbation.m_nSeed);
+
+	// Register dashboard values.
+	m_nPoseXHandle		= m_pTelemetry->RegisterNumber("Sim Pose X (m)", 0.005);
+	m_nPoseYHandle		= m_pTelemetry->RegisterNumber("Sim Pose Y (m)", 0.005);
+	m_nBallsScoredHandle= m_pTelemetry->RegisterNumber("Sim Balls Scored", 0.500);
+	m_nBatteryHandle	= m_pTelemetry->RegisterNumber("Sim Battery (V)", 0.050);
+
+	Reset(Pose2d(), 0);
+}
+
+/******************************************************************************
+	Description:	CRobotSim destructor, delete variables
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CRobotSim::~CRobotSim()
+{
+	StopAccelerated();
+	if (m_StepThread.joinable()) m_StepThread.join();
+
+	delete m_pDriveSim;
+	delete m_pFlywheelSim;
+	delete m_pBackInfraredSim;
+	delete m_pTopInfraredSim;
+	delete m_pIntakeDownSim;
+	delete m_pIntakeUpSim;
+
+	m_pDriveSim			= nullptr;
+	m_pFlywheelSim		= nullptr;
+	m_pBackInfraredSim	= nullptr;
+	m_pTopInfraredSim	= nullptr;
+	m_pIntakeDownSim	= nullptr;
+	m_pIntakeUpSim		= nullptr;
+}
+
+/******************************************************************************
+	Description:	Put the robot back at the start of a match with one ball
+					preloaded at the top infrared and the intake up
+	Arguments:		const Pose2d& StartPose - Field pose (m)
+					int nFieldBalls - Balls the intake can pick up this run
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::Reset(const Pose2d& StartPose, int nFieldBalls)
+{
+	m_pDriveSim->SetPose(StartPose);
+	m_pFlywheelSim->SetState(Eigen::Matrix<double, 1, 1>{0.000});
+
+	m_dIntakePosition	= 0.000;
+	m_dPickupProgress	= 0.000;
+	m_bBackBall			= false;
+	m_dBackPosition		= 0.000;
+	m_bVerticalBall		= true;
+	m_dVerticalPosition	= dSimVerticalSensorPosition;
+	m_nFieldBalls		= nFieldBalls;
+	m_nBallsFired		= 0;
+	m_nBallsScored		= 0;
+	m_dElapsedTime		= 0.000;
+	m_dFirstShotTime	= -1.000;
+
+	UpdateSensors();
+}
+
+/******************************************************************************
+	Description:	Set the battery, friction and sensor noise for the next run
+					and reseed the noise so the run can be repeated
+	Arguments:		const sSimPerturbation& Perturbation
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::SetPerturbation(const sSimPerturbation& Perturbation)
+{
+	m_Perturbation = Perturbation;
+	m_Random.seed(m_Perturbation.m_nSeed);
+	m_Noise.reset();
+}
+
+/******************************************************************************
+	Description:	Step every model by one period and write the results back
+					to the simulated sensors. Called every dFastTierPeriod,
+					between fast tier ticks, so odometry, the follower and
+					the heading lock see new encoders and gyro every tick.
+	Arguments:		double dPeriod - Step length (s)
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::Tick(double dPeriod)
+{
+	UpdateDrive(dPeriod);
+	UpdateFlywheel(dPeriod);
+	UpdateBalls(dPeriod);
+	UpdateSensors();
+
+	// Sag the battery by what the drive and flywheel pulled this step.
+	sim::RoboRioSim::SetVInVoltage(sim::BatterySim::Calculate(volt_t(m_Perturbation.m_dBatteryVoltage), ohm_t(m_Perturbation.m_dBatteryResistance), {m_pDriveSim->GetCurrentDraw(), m_pFlywheelSim->GetCurrentDraw()}));
+	m_dElapsedTime += dPeriod;
+
+	const Pose2d Pose = m_pDriveSim->GetPose();
+	m_pTelemetry->SetNumber(m_nPoseXHandle, Pose.X().value());
+	m_pTelemetry->SetNumber(m_nPoseYHandle, Pose.Y().value());
+	m_pTelemetry->SetNumber(m_nBallsScoredHandle, m_nBallsScored);
+	m_pTelemetry->SetNumber(m_nBatteryHandle, RobotController::GetBatteryVoltage().value());
+}
+
+/******************************************************************************
+	Description:	Pause the sim clock and step it from a background thread as
+					fast as the robot loop keeps up. StepTiming() waits for
+					every notifier due in the step, so the loop still sees a
+					fixed period, it just doesn't wait for the wall clock.
+					Only once per process, see StopAccelerated().
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::StartAccelerated()
+{
+	if (m_bAccelerated || m_StepThread.joinable()) return;
+
+	m_bAccelerated = true;
+	sim::PauseTiming();
+	m_StepThread = thread([this]
+	{
+		while (m_bAccelerated) sim::StepTiming(second_t(dSimStepPeriod));
+	});
+}
+
+/******************************************************************************
+	Description:	Go back to stepping with the wall clock. Safe to call from
+					the robot loop, the step thread is waiting on the loop so
+					it's only joined in the destructor.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::StopAccelerated()
+{
+	if (!m_bAccelerated) return;
+
+	m_bAccelerated = false;
+	sim::ResumeTiming();
+}
+
+/******************************************************************************
+	Description:	Step the drivetrain. The Phoenix sim collections work in
+					each motor's own direction, so the inverted left side is
+					negated both ways.
+	Arguments:		double dPeriod - Step length (s)
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::UpdateDrive(double dPeriod)
+{
+	const double dBattery	= RobotController::GetBatteryVoltage().value();
+	TalonFXSimCollection& LeftSim	= m_pDrive->GetLeftMotorPointer()->GetSimCollection();
+	TalonFXSimCollection& RightSim	= m_pDrive->GetRightMotorPointer()->GetSimCollection();
+	LeftSim.SetBusVoltage(dBattery);
+	RightSim.SetBusVoltage(dBattery);
+
+	const double dFriction	= kDefaultS.value() * m_Perturbation.m_dFrictionScale;
+	const double dLeftInput	= ApplyFriction(-LeftSim.GetMotorOutputLeadVoltage(), m_pDriveSim->GetLeftVelocity().value(), dFriction);
+	const double dRightInput= ApplyFriction(RightSim.GetMotorOutputLeadVoltage(), m_pDriveSim->GetRightVelocity().value(), dFriction);
+	m_pDriveSim->SetInputs(volt_t(dLeftInput), volt_t(dRightInput));
+	m_pDriveSim->Update(second_t(dPeriod));
+
+	// Encoder units per inch of travel, the inverse of CFalconMotion::GetActual().
+	const double dUnitsPerInch = dDefaultFalconMotionRevsPerUnit * nDefaultFalconMotionPulsesPerRev;
+	const double dLeftInches	= (m_pDriveSim->GetLeftPosition().value() * 39.3701) + (m_Noise(m_Random) * m_Perturbation.m_dEncoderNoise);
+	const double dRightInches	= (m_pDriveSim->GetRightPosition().value() * 39.3701) + (m_Noise(m_Random) * m_Perturbation.m_dEncoderNoise);
+	const double dLeftSpeed		= m_pDriveSim->GetLeftVelocity().value() * 39.3701;
+	const double dRightSpeed	= m_pDriveSim->GetRightVelocity().value() * 39.3701;
+	LeftSim.SetIntegratedSensorRawPosition((int)(-dLeftInches * dUnitsPerInch));
+	LeftSim.SetIntegratedSensorVelocity((int)(-dLeftSpeed * dUnitsPerInch / dDefaultFalconMotionTimeUnitInterval));
+	RightSim.SetIntegratedSensorRawPosition((int)(dRightInches * dUnitsPerInch));
+	RightSim.SetIntegratedSensorVelocity((int)(dRightSpeed * dUnitsPerInch / dDefaultFalconMotionTimeUnitInterval));
+
+	// navX convention, clockwise positive.
+	m_pDrive->SetSimulatedHeading(-m_pDriveSim->GetHeading().Degrees().value() + (m_Noise(m_Random) * m_Perturbation.m_dGyroNoise));
+}
+
+/******************************************************************************
+	Description:	Step the flywheel. The Talon's own velocity loop runs in
+					the Phoenix sim with the kP/kF from CShooter::Init(), this
+					only turns its output voltage into speed.
+	Arguments:		double dPeriod - Step length (s)
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::UpdateFlywheel(double dPeriod)
+{
+	TalonFXSimCollection& FlywheelSim = m_pShooter->GetFlywheelMotorPointer()->GetSimCollection();
+	FlywheelSim.SetBusVoltage(RobotController::GetBatteryVoltage().value());
+
+	m_pFlywheelSim->SetInputVoltage(volt_t(FlywheelSim.GetMotorOutputLeadVoltage()));
+	m_pFlywheelSim->Update(second_t(dPeriod));
+
+	// Sensor units per 100ms, 2048 per revolution.
+	const double dRevsPerSecond = m_pFlywheelSim->GetAngularVelocity().value() / (2.000 * M_PI);
+	FlywheelSim.SetIntegratedSensorVelocity((int)(dRevsPerSecond * 2048.000 / 10.000));
+	FlywheelSim.AddIntegratedSensorPosition((int)(dRevsPerSecond * 2048.000 * dPeriod));
+}
+
+/******************************************************************************
+	Description:	Move balls through the intake, back transfer and vertical
+					transfer from what each motor is commanded to do. A ball
+					leaving the top of the vertical transfer is fired, and
+					scores if the flywheel was within tolerance.
+	Arguments:		double dPeriod - Step length (s)
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::UpdateBalls(double dPeriod)
+{
+	// Intake deploy, positive output takes it down.
+	m_dIntakePosition += m_pIntake->GetDeployOutput() * dPeriod / dSimIntakeDeployTime;
+	m_dIntakePosition = clamp(m_dIntakePosition, 0.000, 1.000);
+
+	// Pick up a ball after driving over it long enough with the intake down and running.
+	const double dSpeed = fabs((m_pDriveSim->GetLeftVelocity() + m_pDriveSim->GetRightVelocity()).value() / 2.000);
+	if ((m_nFieldBalls > 0) && !m_bBackBall && (m_dIntakePosition >= 1.000) && (fabs(m_pIntake->GetIntakeOutput()) > 0.100) && (dSpeed > dSimPickupMinSpeed))
+	{
+		m_dPickupProgress += dPeriod / dSimPickupTime;
+		if (m_dPickupProgress >= 1.000)
+		{
+			m_nFieldBalls--;
+			m_bBackBall			= true;
+			m_dBackPosition		= 0.000;
+			m_dPickupProgress	= 0.000;
+		}
+	}
+
+	// Back transfer, positive output carries the ball to the vertical transfer.
+	if (m_bBackBall)
+	{
+		m_dBackPosition += m_pTransfer->GetBackOutput() * dPeriod / dSimBackTransferTime;
+		m_dBackPosition = clamp(m_dBackPosition, 0.000, 1.000);
+		if ((m_dBackPosition >= 1.000) && !m_bVerticalBall)
+		{
+			m_bBackBall			= false;
+			m_bVerticalBall		= true;
+			m_dVerticalPosition	= 0.000;
+		}
+	}
+
+	// Vertical transfer, negative output lifts the ball into the flywheel.
+	if (m_bVerticalBall)
+	{
+		m_dVerticalPosition -= m_pTransfer->GetVerticalOutput() * dPeriod / dSimVerticalTravelTime;
+		m_dVerticalPosition = max(m_dVerticalPosition, 0.000);
+		if (m_dVerticalPosition >= 1.000)
+		{
+			const double dVelocity = m_pFlywheelSim->GetAngularVelocity().value() / (2.000 * M_PI) * 2048.000 / 10.000;
+			const double dExpected = m_pShooter->GetExpectedShotVelocity();
+			if (fabs(dVelocity - dExpected) <= (dExpected * dSimShotVelocityTolerance)) m_nBallsScored++;
+			if (m_dFirstShotTime < 0.000) m_dFirstShotTime = m_dElapsedTime;
+			m_nBallsFired++;
+			m_bVerticalBall = false;
+			m_pFlywheelSim->SetState(Eigen::Matrix<double, 1, 1>{m_pFlywheelSim->GetAngularVelocity().value() * dSimShotSpeedRetained});
+		}
+	}
+}
+
+/******************************************************************************
+	Description:	Write ball and intake positions to the DIO sims. Every one
+					of these inputs reads false when the beam is broken or the
+					switch is pressed.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CRobotSim::UpdateSensors()
+{
+	const bool bTopBroken	= m_bVerticalBall && (m_dVerticalPosition >= dSimVerticalSensorPosition);
+	const bool bBackBroken	= m_bBackBall;
+	m_pTopInfraredSim->SetValue(!bTopBroken);
+	m_pBackInfraredSim->SetValue(!bBackBroken);
+	m_pIntakeDownSim->SetValue(!(m_dIntakePosition >= 1.000));
+	m_pIntakeUpSim->SetValue(!(m_dIntakePosition <= 0.000));
+}
+
+/******************************************************************************
+	Description:	Take friction out of a motor voltage. Kinetic friction
+					opposes the wheel while it's moving, static friction holds
+					it until the voltage beats it.
+	Arguments:		double dVoltage - Applied voltage (V)
+					double dVelocity - Wheel speed (m/s)
+					double dFriction - Friction voltage (V)
+	Returns:		double - Voltage left to accelerate the wheel (V)
+******************************************************************************/
+double CRobotSim::ApplyFriction(double dVoltage, double dVelocity, double dFriction)
+{
+	if (fabs(dVelocity) > 0.010) return dVoltage - copysign(dFriction, dVelocity);
+	if (fabs(dVoltage) <= dFriction) return 0.000;
+	return dVoltage - copysign(dFriction, dVoltage);
+}
@@ -5,20 +5,53 @@
 ******************************************************************************/
 
 #include "Shooter.h"
+#include "LoopProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <frc/Timer.h>
 #include <frc/smartdashboard/SmartDashboard.h>
 ///////////////////////////////////////////////////////////////////////////////
 
 /******************************************************************************
 	Description:	CShooter constructor, init variables
-	Arguments:		None
+	Arguments:		CTelemetry* pTelemetry, CCommandCache* pCommandCache
 	Derived from:	Nothing
 ******************************************************************************/
-CShooter::CShooter() {
+CShooter::CShooter(CTelemetry* pTelemetry, CCommandCache* pCommandCache) :
+	m_VelocityFilter(LinearFilter<double>::SinglePoleIIR(dShooterFilterTimeConstant, units::second_t(dFastTierPeriod)))
+{
 	m_pFlywheelMotor1		= new WPI_TalonFX(nFlywheelMotor1);
 	m_pFlywheelMotor2		= new WPI_TalonFX(nFlywheelMotor2);
+	m_pTelemetry			= pTelemetry;
+	m_pCommandCache			= pCommandCache;
+	m_nFlywheelCommand		= m_pCommandCache->Register();
+	m_nVelocityHandle		= m_pTelemetry->RegisterNumber("dMotor1Velocity", 5.000);
+	m_nReadyInHandle		= m_pTelemetry->RegisterNumber("Shooter Ready In (ms)", 5.000);
+	m_nLastRecoveryHandle	= m_pTelemetry->RegisterNumber("Shooter Last Recovery (ms)", 1.000);
+	m_nMeanRecoveryHandle	= m_pTelemetry->RegisterNumber("Shooter Mean Recovery (ms)", 1.000);
+	m_nShotCountHandle		= m_pTelemetry->RegisterNumber("Shooter Shots", 0.500);
+	m_nHubDistanceHandle	= m_pTelemetry->RegisterNumber("Shooter Hub Distance (mm)", 10.000);
+	m_nShotVelocityHandle	= m_pTelemetry->RegisterNumber("Shooter Shot Velocity", 5.000);
+	m_nExpectedShotHandle	= m_pTelemetry->RegisterNumber("dExpectedShotVelocity");
+	m_nExpectedIdleHandle	= m_pTelemetry->RegisterNumber("dExpectedIdleVelocity");
+	m_pShotTable			= new CShotTable();
 
 	m_bSafety				= true;
 	m_bIdle					= true;
+	m_bShooterOn			= false;
+	m_bShooterFullSpeed		= false;
+	m_dFlywheelVelocity		= 0.000;
+	m_dFilteredVelocity		= 0.000;
+	m_dAcceleration			= 0.000;
+	m_bShotArmed			= false;
+	m_bRecovering			= false;
+	m_dShotTime				= 0.000;
+	m_dLastRecovery			= 0.000;
+	m_dMeanRecovery			= dShooterDefaultRecovery;
+	m_dReadyIn				= -1.000;
+	m_nShotCount			= 0;
+	m_dHubDistance			= -1.000;
+	m_dShotTrim				= 0.000;
 }		
 
 /******************************************************************************
@@ -30,9 +63,11 @@ CShooter::~CShooter()
 {
 	delete m_pFlywheelMotor1;		
 	delete m_pFlywheelMotor2;
+	delete m_pShotTable;
 
 	m_pFlywheelMotor1		= nullptr;
-	m_pFlywheelMotor2		= nullptr;	
+	m_pFlywheelMotor2		= nullptr;
+	m_pShotTable			= nullptr;	
 }
 
 /******************************************************************************
@@ -42,7 +77,7 @@ CShooter::~CShooter()
 ******************************************************************************/
 void CShooter::Stop()
 {
-	m_pFlywheelMotor1->Set(0.000);
+	m_pCommandCache->Set(m_nFlywheelCommand, m_pFlywheelMotor1, ControlMode::PercentOutput, 0.000);
 	m_bShooterOn = false;
 }
 
@@ -82,8 +117,27 @@ void CShooter::Init()
 	m_bShooterOn = false;
 	m_bShooterFullSpeed = false;
 
-	SmartDashboard::PutNumber("dExpectedShotVelocity", m_dExpectedShotVelocity);
-	SmartDashboard::PutNumber("dExpectedIdleVelocity", m_dExpectedIdleVelocity);
+	// The hub has to be seen again this period before the table picks the speed.
+	m_dHubDistance = -1.000;
+	UpdateShotVelocity();
+
+	m_pTelemetry->SetNumber(m_nExpectedShotHandle, m_dExpectedShotVelocity);
+	m_pTelemetry->SetNumber(m_nExpectedIdleHandle, m_dExpectedIdleVelocity);
+}
+
+/******************************************************************************
+	Description:	Declare the CAN signals the shooter reads. At speed detection
+					reads the flywheel velocity every fast tier tick and the
+					second flywheel motor follows the first.
+	Arguments:		CStatusFramePlanner* pPlanner
+	Returns:		Nothing
+******************************************************************************/
+void CShooter::ConfigureStatusFrames(CStatusFramePlanner* pPlanner)
+{
+	const int nDevice = pPlanner->AddTalon(m_pFlywheelMotor1, eCanTalonFX);
+	pPlanner->Require(nDevice, eSignalOutput, 10);
+	pPlanner->Require(nDevice, eSignalVelocity, 10);
+	pPlanner->AddTalon(m_pFlywheelMotor2, eCanTalonFX);
 }
 
 /******************************************************************************
@@ -95,7 +149,7 @@ void CShooter::StartFlywheelShot()
 {
 	if (!m_bSafety) 
 	{
-		m_pFlywheelMotor1->Set(ControlMode::Velocity, m_dExpectedShotVelocity);
+		m_pCommandCache->Set(m_nFlywheelCommand, m_pFlywheelMotor1, ControlMode::Velocity, m_dExpectedShotVelocity);
 		m_bShooterOn = true;
 		m_bIdle = false;
 	}
@@ -109,7 +163,7 @@ void CShooter::StartFlywheelShot()
 ******************************************************************************/
 void CShooter::IdleStop() {
 	if(!m_bSafety) {
-		m_pFlywheelMotor1->Set(ControlMode::Velocity, m_dExpectedIdleVelocity);
+		m_pCommandCache->Set(m_nFlywheelCommand, m_pFlywheelMotor1, ControlMode::Velocity, m_dExpectedIdleVelocity);
 		m_bShooterOn = true;
 		m_bIdle = true;
 	}
@@ -117,15 +171,68 @@ void CShooter::IdleStop() {
 }
 
 /******************************************************************************
-	Description:	A tick function that checks the speed of the flywheel to see if it is at full speed.
+	Description:	Fast tier tick that filters the flywheel speed, decides if it
+					is at full speed, spots balls going through from the dip
+					they cause and times how long the wheel takes to recover.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CShooter::FastTick() {
+	PROFILE_SCOPE(eProfileShooterTick);
+	const double dTime = (double)Timer::GetFPGATimestamp();
+	m_dFlywheelVelocity = m_pFlywheelMotor1->GetSelectedSensorVelocity();
+	const double dFiltered = m_VelocityFilter.Calculate(m_dFlywheelVelocity);
+	m_dAcceleration = (dFiltered - m_dFilteredVelocity) / dFastTierPeriod;
+	m_dFilteredVelocity = dFiltered;
+
+	const double dError = m_dExpectedShotVelocity - m_dFilteredVelocity;
+	m_bShooterFullSpeed = (fabs(dError) < dShooterReadyTolerance);
+
+	// Only a dip while spinning at shot speed is a ball, idling and stopping slow it down too.
+	const bool bShooting = m_bShooterOn && !m_bIdle;
+	if (!bShooting)
+	{
+		m_bShotArmed = false;
+		m_bRecovering = false;
+	}
+	else if (m_bShooterFullSpeed)
+	{
+		if (m_bRecovering)
+		{
+			m_dLastRecovery = dTime - m_dShotTime;
+			m_dMeanRecovery += dShooterRecoveryGain * (m_dLastRecovery - m_dMeanRecovery);
+			m_bRecovering = false;
+		}
+		m_bShotArmed = true;
+	}
+	else if (m_bShotArmed && (dError > dShooterShotDip))
+	{
+		m_nShotCount++;
+		m_dShotTime = dTime;
+		m_bShotArmed = false;
+		m_bRecovering = true;
+	}
+
+	// Predict when it'll be at speed, from recovery history after a shot or from the spin up rate before the first.
+	if (m_bShooterFullSpeed) m_dReadyIn = 0.000;
+	else if (m_bRecovering) m_dReadyIn = max(m_dMeanRecovery - (dTime - m_dShotTime), 0.000);
+	else if (bShooting && (dError > 0.000) && (m_dAcceleration > 0.000)) m_dReadyIn = (dError - dShooterReadyTolerance) / m_dAcceleration;
+	else m_dReadyIn = -1.000;
+}
+
+/******************************************************************************
+	Description:	Slow tier tick, publishes the flywheel velocity and readiness.
 	Arguments:		None
 	Returns:		Nothing
 ******************************************************************************/
 void CShooter::Tick() {
-	double dMotor1Velocity = m_pFlywheelMotor1->GetSelectedSensorVelocity();
-	SmartDashboard::PutNumber("dMotor1Velocity", dMotor1Velocity);
-	double dVelocityDiff = abs(dMotor1Velocity - m_dExpectedShotVelocity);
-	m_bShooterFullSpeed = (dVelocityDiff < 100);
+	m_pTelemetry->SetNumber(m_nVelocityHandle, m_dFlywheelVelocity);
+	m_pTelemetry->SetNumber(m_nReadyInHandle, m_dReadyIn * 1000.000);
+	m_pTelemetry->SetNumber(m_nLastRecoveryHandle, m_dLastRecovery * 1000.000);
+	m_pTelemetry->SetNumber(m_nMeanRecoveryHandle, m_dMeanRecovery * 1000.000);
+	m_pTelemetry->SetNumber(m_nShotCountHandle, m_nShotCount);
+	m_pTelemetry->SetNumber(m_nHubDistanceHandle, m_dHubDistance);
+	m_pTelemetry->SetNumber(m_nShotVelocityHandle, m_dExpectedShotVelocity);
 }
 
 /******************************************************************************
@@ -136,13 +243,67 @@ void CShooter::Tick() {
 void CShooter::AdjustVelocity(double dVelocityPercent) {
 	m_dFlywheelMotorSpeed += dVelocityPercent;
 	m_dIdleMotorSpeed += dVelocityPercent;
+	m_dShotTrim += dVelocityPercent;
 
-    m_dExpectedShotVelocity = m_dPeakSensorVelocity * m_dFlywheelMotorSpeed;
+    m_dExpectedShotVelocity = m_dPeakSensorVelocity * GetShotSpeed();
     m_dExpectedIdleVelocity = m_dPeakSensorVelocity * m_dIdleMotorSpeed;
 
-	SmartDashboard::PutNumber("dExpectedShotVelocity", m_dExpectedShotVelocity);
-	SmartDashboard::PutNumber("dExpectedIdleVelocity", m_dExpectedIdleVelocity);
+	m_pTelemetry->SetNumber(m_nExpectedShotHandle, m_dExpectedShotVelocity);
+	m_pTelemetry->SetNumber(m_nExpectedIdleHandle, m_dExpectedIdleVelocity);
 
-	if(m_bIdle) m_pFlywheelMotor1->Set(ControlMode::Velocity, m_dExpectedIdleVelocity);
-	else m_pFlywheelMotor1->Set(ControlMode::Velocity, m_dExpectedShotVelocity);
-}
\ No newline at end of file
+	if(m_bIdle) m_pCommandCache->Set(m_nFlywheelCommand, m_pFlywheelMotor1, ControlMode::Velocity, m_dExpectedIdleVelocity);
+	else m_pCommandCache->Set(m_nFlywheelCommand, m_pFlywheelMotor1, ControlMode::Velocity, m_dExpectedShotVelocity);
+}
+/******************************************************************************
+	Description:	Reload the distance to speed table from the deploy
+					directory, called from RobotInit and DisabledInit
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CShooter::LoadShotTable() {
+	m_pShotTable->Load();
+	UpdateShotVelocity();
+}
+
+/******************************************************************************
+	Description:	Set the distance to the hub, so the flywheel tracks the
+					right speed while driving
+	Arguments:		double dDistance - Hub distance (mm)
+	Returns:		Nothing
+******************************************************************************/
+void CShooter::SetHubDistance(double dDistance) {
+	if(dDistance <= 0.000) return;
+	m_dHubDistance = dDistance;
+	UpdateShotVelocity();
+}
+
+/******************************************************************************
+	Description:	Forget the hub distance once its track is gone, so the shot
+					goes back to the fixed flywheel speed instead of the last
+					distance seen
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CShooter::ClearHubDistance() {
+	if(m_dHubDistance < 0.000) return;
+	m_dHubDistance = -1.000;
+	UpdateShotVelocity();
+}
+
+/******************************************************************************
+	Description:	Recompute the shot velocity and send it if the flywheel is
+					spinning for a shot. Changes inside the deadband are held.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CShooter::UpdateShotVelocity() {
+	const double dVelocity = m_dPeakSensorVelocity * GetShotSpeed();
+	const double dChange = fabs(dVelocity - m_dExpectedShotVelocity);
+	if(dChange < dShooterSetpointDeadband) return;
+
+	// A large setpoint step looks just like the dip from a ball, wait until it's back at speed.
+	if(dChange >= dShooterReadyTolerance) m_bShotArmed = false;
+
+	m_dExpectedShotVelocity = dVelocity;
+	if(m_bShooterOn && !m_bIdle && !m_bSafety) m_pCommandCache->Set(m_nFlywheelCommand, m_pFlywheelMotor1, ControlMode::Velocity, m_dExpectedShotVelocity);
+}
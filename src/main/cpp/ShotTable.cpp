@@ -0,0 +1,145 @@
+/******************************************************************************
+	Description:	CShotTable implementation
+	Class:			CShotTable
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "ShotTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <frc/DriverStation.h>
+#include <frc/Filesystem.h>
+
+using namespace frc;
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CShotTable constructor, init variables
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CShotTable::CShotTable()
+{
+	m_dMinDistance = 0.000;
+	m_dMaxDistance = 0.000;
+}
+
+/******************************************************************************
+	Description:	Read the table file and resample it. A bad file is reported
+					and leaves the table empty, so the shooter falls back to
+					its fixed speed.
+	Arguments:		None
+	Returns:		bool - True if a table was loaded
+******************************************************************************/
+bool CShotTable::Load()
+{
+	m_vSpeeds.clear();
+
+	const string strFile = frc::filesystem::GetDeployDirectory() + "/" + pszShotTableFile;
+	ifstream File(strFile);
+	if (!File.is_open())
+	{
+		DriverStation::ReportWarning(strFile + ": not found, using the fixed shot speed");
+		return false;
+	}
+
+	// Read the measured points.
+	vector<pair<double, double>> vPoints;
+	string strLine;
+	int nLine = 0;
+	while (getline(File, strLine))
+	{
+		nLine++;
+		const size_t nComment = strLine.find('#');
+		if (nComment != string::npos) strLine.erase(nComment);
+		replace(strLine.begin(), strLine.end(), ',', ' ');
+		if (strLine.find_first_not_of(" \t\r") == string::npos) continue;
+
+		istringstream Line(strLine);
+		double dDistance;
+		double dSpeed;
+		string strExtra;
+		if (!(Line >> dDistance >> dSpeed) || (Line >> strExtra) || (dDistance < 0.000) || (dSpeed <= 0.000) || (dSpeed > 1.000))
+		{
+			DriverStation::ReportError(strFile + ":" + to_string(nLine) + ": expected a distance (mm) and a speed between 0 and 1");
+			return false;
+		}
+		vPoints.emplace_back(dDistance, dSpeed);
+	}
+
+	// Lookups interpolate between neighbours, so the distances have to strictly increase.
+	sort(vPoints.begin(), vPoints.end());
+	for (size_t i = 1; i < vPoints.size(); i++)
+	{
+		if (vPoints[i].first == vPoints[i - 1].first)
+		{
+			DriverStation::ReportError(strFile + ": distance " + to_string(vPoints[i].first) + " is listed twice");
+			return false;
+		}
+	}
+	if (vPoints.empty())
+	{
+		DriverStation::ReportWarning(strFile + ": no points, using the fixed shot speed");
+		return false;
+	}
+	if (vPoints.size() < 2)
+	{
+		DriverStation::ReportError(strFile + ": needs at least two points");
+		return false;
+	}
+
+	const double dSpan = vPoints.back().first - vPoints.front().first;
+	const int nEntries = (int)ceil(dSpan / dShotTableStep) + 1;
+	if (nEntries > nShotTableMaxEntries)
+	{
+		DriverStation::ReportError(strFile + ": distances span more than " + to_string((int)(nShotTableMaxEntries * dShotTableStep)) + "mm");
+		return false;
+	}
+
+	// Resample onto the even grid, walking the points once since both are sorted. The last
+	// entry can land past the last point, it carries on along the last segment instead of
+	// being clamped, so the final step is as wide as the rest.
+	m_dMinDistance = vPoints.front().first;
+	m_dMaxDistance = vPoints.back().first;
+	m_vSpeeds.resize(nEntries);
+	size_t nSegment = 0;
+	for (int i = 0; i < nEntries; i++)
+	{
+		const double dDistance = m_dMinDistance + (i * dShotTableStep);
+		while ((nSegment + 2 < vPoints.size()) && (dDistance > vPoints[nSegment + 1].first)) nSegment++;
+
+		const pair<double, double>& Low = vPoints[nSegment];
+		const pair<double, double>& High = vPoints[nSegment + 1];
+		const double dFraction = (dDistance - Low.first) / (High.first - Low.first);
+		m_vSpeeds[i] = Low.second + (dFraction * (High.second - Low.second));
+	}
+
+	return true;
+}
+
+/******************************************************************************
+	Description:	Flywheel speed for a hub distance, held at the end values
+					outside the measured range. Clamping to the last point
+					before indexing keeps the extrapolated last entry from
+					being read past it.
+	Arguments:		double dDistance - Hub distance (mm)
+	Returns:		double - Fraction of peak speed, zero if nothing is loaded
+******************************************************************************/
+double CShotTable::Lookup(double dDistance) const
+{
+	if (m_vSpeeds.empty()) return 0.000;
+
+	const double dIndex = (min(dDistance, m_dMaxDistance) - m_dMinDistance) * (1.000 / dShotTableStep);
+	if (dIndex <= 0.000) return m_vSpeeds.front();
+
+	const size_t nIndex = (size_t)dIndex;
+	if (nIndex + 1 >= m_vSpeeds.size()) return m_vSpeeds.back();
+
+	const double dFraction = dIndex - nIndex;
+	return m_vSpeeds[nIndex] + (dFraction * (m_vSpeeds[nIndex + 1] - m_vSpeeds[nIndex]));
+}
@@ -0,0 +1,192 @@
+/******************************************************************************
+	Description:	CSimScenario implementation
+	Class:			CSimScenario
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "SimScenario.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <fmt/format.h>
+#include <frc/Timer.h>
+#include <frc/simulation/DriverStationSim.h>
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CSimScenario constructor, init variables
+	Arguments:		const sSimScenario& Scenario
+					CRobotSim* pRobotSim
+					CDrive* pDrive
+					CTargetTracker* pTargetTracker
+	Derived from:	Nothing
+******************************************************************************/
+CSimScenario::CSimScenario(const sSimScenario& Scenario, CRobotSim* pRobotSim, CDrive* pDrive, CTargetTracker* pTargetTracker)
+{
+	m_Scenario			= Scenario;
+	m_pRobotSim			= pRobotSim;
+	m_pDrive			= pDrive;
+	m_pTargetTracker	= pTargetTracker;
+	m_bFinished			= false;
+	m_dAimHeading		= 0.000;
+	m_dLastFrameTime	= -1.000;
+}
+
+/******************************************************************************
+	Description:	Reset the models, start stepping faster than real time and
+					enable autonomous
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CSimScenario::Start()
+{
+	m_pRobotSim->SetPerturbation(m_Scenario.m_Perturbation);
+	m_pRobotSim->Reset(Pose2d(), m_Scenario.m_nFieldBalls);
+	m_pRobotSim->StartAccelerated();
+
+	sim::DriverStationSim::SetDsAttached(true);
+	sim::DriverStationSim::SetAutonomous(true);
+	sim::DriverStationSim::SetEnabled(true);
+	sim::DriverStationSim::NotifyNewData();
+}
+
+/******************************************************************************
+	Description:	Check whether autonomous has run its full length, and if so
+					disable the robot and write the results
+	Arguments:		None
+	Returns:		bool - True once the run is over and the robot can exit
+******************************************************************************/
+bool CSimScenario::Tick()
+{
+	if (m_bFinished) return true;
+	if (m_Scenario.m_dAimAngle != 0.000) TickAim();
+	if (m_pRobotSim->GetElapsedTime() < m_Scenario.m_dDuration) return false;
+
+	sim::DriverStationSim::SetEnabled(false);
+	sim::DriverStationSim::NotifyNewData();
+	m_pRobotSim->StopAccelerated();
+	WriteResult();
+	m_bFinished = true;
+	return true;
+}
+
+/******************************************************************************
+	Description:	Feed the target tracker a hub frame every frame period, the
+					way ReadSensors() does with the coprocessor's, then aim the
+					way the teleop vision code does. Each frame reports the
+					hub as the front camera saw it one pipeline latency ago,
+					rounded to whole pixels, and is empty once the hub is out
+					of view.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CSimScenario::TickAim()
+{
+	const double dElapsed = m_pRobotSim->GetElapsedTime();
+	if (dElapsed < dSimAimStart) return;
+	if ((m_dLastFrameTime < 0.000) || ((dElapsed - m_dLastFrameTime) >= m_Scenario.m_dAimFramePeriod))
+	{
+		const double dCaptureTime = (double)Timer::GetFPGATimestamp() - dVisionPipelineLatency;
+		const double dCaptureHeading = m_pDrive->GetHeadingAt(dCaptureTime);
+		if (m_dLastFrameTime < 0.000) m_dAimHeading = dCaptureHeading + m_Scenario.m_dAimAngle;
+		m_dLastFrameTime = dElapsed;
+
+		const double dX = 160.000 + round((m_dAimHeading - dCaptureHeading) / dAnglePerPixel);
+		CDetectionBatch& Batch = m_AimFrame.m_Batch;
+		m_AimFrame.m_kDetectionLocation	= eFrontCamera;
+		m_AimFrame.m_dTimestamp			= dCaptureTime;
+		Batch.m_nCount					= ((dX >= 0.000) && (dX < 320.000)) ? 1 : 0;
+		Batch.m_anX[0]					= (uint16_t)max(dX, 0.000);
+		Batch.m_anY[0]					= 120;
+		Batch.m_anWidth[0]				= 40;
+		Batch.m_anHeight[0]				= 20;
+		Batch.m_anConfidence[0]			= 255;
+		Batch.m_anClass[0]				= eHub;
+		Batch.m_anDepth[0]				= 0;
+		m_pTargetTracker->Update(&m_AimFrame, dCaptureHeading);
+	}
+
+	// Lock onto where the track says the hub is now, same as TeleopPeriodic().
+	const sTargetTrack* pHubTrack = m_pTargetTracker->GetBest(eHub);
+	if (pHubTrack != nullptr) m_pDrive->AimAtHeading(CTargetTracker::PredictBearing(*pHubTrack, (double)Timer::GetFPGATimestamp()));
+}
+
+/******************************************************************************
+	Description:	Read a scenario from the environment. SIM_PATH selects the
+					run, everything else is optional.
+	Arguments:		sSimScenario& Scenario - Filled in on success
+	Returns:		bool - True if SIM_PATH was set
+******************************************************************************/
+bool CSimScenario::FromEnvironment(sSimScenario& Scenario)
+{
+	auto GetNumber = [](const char* pszName, double dDefault)
+	{
+		const char* pszValue = getenv(pszName);
+		return (pszValue != nullptr) ? atof(pszValue) : dDefault;
+	};
+
+	const char* pszPath = getenv("SIM_PATH");
+	if (pszPath == nullptr) return false;
+
+	const int nPath = atoi(pszPath);
+	Scenario.m_nPath = ((nPath >= 0) && (nPath < nPathCount)) ? (Paths)nPath : eAutoIdle;
+	Scenario.m_Perturbation.m_nSeed					= (unsigned)GetNumber("SIM_SEED", 0.000);
+	Scenario.m_Perturbation.m_dBatteryVoltage		= GetNumber("SIM_BATTERY", Scenario.m_Perturbation.m_dBatteryVoltage);
+	Scenario.m_Perturbation.m_dBatteryResistance	= GetNumber("SIM_BATTERY_RESISTANCE", Scenario.m_Perturbation.m_dBatteryResistance);
+	Scenario.m_Perturbation.m_dFrictionScale		= GetNumber("SIM_FRICTION", Scenario.m_Perturbation.m_dFrictionScale);
+	Scenario.m_Perturbation.m_dEncoderNoise			= GetNumber("SIM_ENCODER_NOISE", Scenario.m_Perturbation.m_dEncoderNoise);
+	Scenario.m_Perturbation.m_dGyroNoise			= GetNumber("SIM_GYRO_NOISE", Scenario.m_Perturbation.m_dGyroNoise);
+	Scenario.m_nFieldBalls							= (int)GetNumber("SIM_FIELD_BALLS", Scenario.m_nFieldBalls);
+	Scenario.m_dDuration							= GetNumber("SIM_DURATION", Scenario.m_dDuration);
+	Scenario.m_dAimAngle							= GetNumber("SIM_AIM", Scenario.m_dAimAngle);
+	Scenario.m_dAimFramePeriod						= GetNumber("SIM_AIM_FRAME_PERIOD", Scenario.m_dAimFramePeriod);
+
+	const char* pszResult = getenv("SIM_RESULT");
+	Scenario.m_strResultFile = (pszResult != nullptr) ? pszResult : "";
+	return true;
+}
+
+/******************************************************************************
+	Description:	Write the run's results as one JSON line. Pose error is
+					against the end of the trajectory for trajectory paths and
+					-1 for the timed ones, odometry error is always against the
+					simulated pose. Aim error is how far off the hub the gyro
+					ended up.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CSimScenario::WriteResult()
+{
+	const Pose2d Actual		= m_pRobotSim->GetPose();
+	const Pose2d Odometry	= m_pDrive->GetPose();
+	const Trajectory* pTrajectory = m_pDrive->GetArmedTrajectory();
+
+	double dPoseError = -1.000;
+	if ((pTrajectory != nullptr) && !pTrajectory->States().empty())
+	{
+		dPoseError = Actual.Translation().Distance(pTrajectory->States().back().pose.Translation()).value();
+	}
+	const double dOdometryError = Actual.Translation().Distance(Odometry.Translation()).value();
+	const double dAimError = (m_Scenario.m_dAimAngle != 0.000) ? fabs(m_dAimHeading - m_pDrive->GetHeadingAt((double)Timer::GetFPGATimestamp())) : 0.000;
+
+	const string strResult = fmt::format("{{\"path\": {}, \"seed\": {}, \"battery\": {:.3f}, \"friction\": {:.3f}, \"encoder_noise\": {:.4f}, \"gyro_noise\": {:.4f}, "
+		"\"x\": {:.4f}, \"y\": {:.4f}, \"heading\": {:.3f}, \"pose_error\": {:.4f}, \"odometry_error\": {:.4f}, "
+		"\"first_shot_time\": {:.3f}, \"balls_fired\": {}, \"balls_scored\": {}, "
+		"\"aim_angle\": {:.2f}, \"aim_settle_time\": {:.3f}, \"aim_error\": {:.3f}}}",
+		(int)m_Scenario.m_nPath, m_Scenario.m_Perturbation.m_nSeed, m_Scenario.m_Perturbation.m_dBatteryVoltage, m_Scenario.m_Perturbation.m_dFrictionScale,
+		m_Scenario.m_Perturbation.m_dEncoderNoise, m_Scenario.m_Perturbation.m_dGyroNoise,
+		Actual.X().value(), Actual.Y().value(), Actual.Rotation().Degrees().value(), dPoseError, dOdometryError,
+		m_pRobotSim->GetFirstShotTime(), m_pRobotSim->GetBallsFired(), m_pRobotSim->GetBallsScored(),
+		m_Scenario.m_dAimAngle, m_pDrive->GetAimSettleTime(), dAimError);
+
+	if (m_Scenario.m_strResultFile.empty())
+	{
+		cout << strResult << endl;
+		return;
+	}
+
+	ofstream Result(m_Scenario.m_strResultFile, ios::app);
+	Result << strResult << endl;
+}
@@ -0,0 +1,243 @@
+/******************************************************************************
+	Description:	CStatusFramePlanner implementation
+	Class:			CStatusFramePlanner
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "StatusFramePlanner.h"
+
+#include <algorithm>
+#include <frc/smartdashboard/SmartDashboard.h>
+
+using namespace ctre::phoenix::motorcontrol;
+using namespace frc;
+///////////////////////////////////////////////////////////////////////////////
+
+// Bit per StatusSignal, for the frame tables.
+#define SIGNAL_BIT(nSignal)		(1u << (nSignal))
+
+// Talon FX status frames, defaults from the Phoenix 5 frame table.
+static const CStatusFramePlanner::sStatusFrame s_aTalonFXFrames[] = {
+	{StatusFrameEnhanced::Status_1_General,			10,		100,					SIGNAL_BIT(eSignalOutput) | SIGNAL_BIT(eSignalLimitSwitch)},
+	{StatusFrameEnhanced::Status_2_Feedback0,		20,		nPhoenixMaxFramePeriod,	SIGNAL_BIT(eSignalVelocity) | SIGNAL_BIT(eSignalPosition)},
+	{StatusFrameEnhanced::Status_4_AinTempVbat,		160,	nPhoenixMaxFramePeriod,	SIGNAL_BIT(eSignalTemperature)},
+	{StatusFrameEnhanced::Status_Brushless_Current,	50,		nPhoenixMaxFramePeriod,	SIGNAL_BIT(eSignalCurrent)},
+	{StatusFrameEnhanced::Status_3_Quadrature,		160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_8_PulseWidth,		160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_10_MotionMagic,	160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_12_Feedback1,		250,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_13_Base_PIDF0,		160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_14_Turn_PIDF1,		250,	nPhoenixMaxFramePeriod,	0}
+};
+
+// Talon SRX status frames, the SRX reports current with the sensor feedback.
+static const CStatusFramePlanner::sStatusFrame s_aTalonSRXFrames[] = {
+	{StatusFrameEnhanced::Status_1_General,			10,		100,					SIGNAL_BIT(eSignalOutput) | SIGNAL_BIT(eSignalLimitSwitch)},
+	{StatusFrameEnhanced::Status_2_Feedback0,		20,		nPhoenixMaxFramePeriod,	SIGNAL_BIT(eSignalVelocity) | SIGNAL_BIT(eSignalPosition) | SIGNAL_BIT(eSignalCurrent)},
+	{StatusFrameEnhanced::Status_4_AinTempVbat,		160,	nPhoenixMaxFramePeriod,	SIGNAL_BIT(eSignalTemperature)},
+	{StatusFrameEnhanced::Status_3_Quadrature,		160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_8_PulseWidth,		160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_10_MotionMagic,	160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_12_Feedback1,		250,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_13_Base_PIDF0,		160,	nPhoenixMaxFramePeriod,	0},
+	{StatusFrameEnhanced::Status_14_Turn_PIDF1,		250,	nPhoenixMaxFramePeriod,	0}
+};
+
+// Spark MAX periodic frames, defaults from the REVLib 2022 frame table.
+static const CStatusFramePlanner::sStatusFrame s_aSparkMaxFrames[] = {
+	{(int)CANSparkMaxLowLevel::PeriodicFrame::kStatus0,	10,		100,	SIGNAL_BIT(eSignalOutput) | SIGNAL_BIT(eSignalLimitSwitch)},
+	{(int)CANSparkMaxLowLevel::PeriodicFrame::kStatus1,	20,		500,	SIGNAL_BIT(eSignalVelocity) | SIGNAL_BIT(eSignalCurrent) | SIGNAL_BIT(eSignalTemperature)},
+	{(int)CANSparkMaxLowLevel::PeriodicFrame::kStatus2,	20,		500,	SIGNAL_BIT(eSignalPosition)},
+	{(int)CANSparkMaxLowLevel::PeriodicFrame::kStatus3,	50,		500,	0},
+	{(int)CANSparkMaxLowLevel::PeriodicFrame::kStatus4,	20,		500,	0}
+};
+
+/******************************************************************************
+	Description:	Add a Talon FX or Talon SRX to the plan
+	Arguments:		BaseTalon* pTalon, CanDeviceType nType
+	Returns:		int - Device handle for Require()
+******************************************************************************/
+int CStatusFramePlanner::AddTalon(BaseTalon* pTalon, CanDeviceType nType)
+{
+	return AddDevice(nType, pTalon, nullptr);
+}
+
+/******************************************************************************
+	Description:	Add a Spark MAX to the plan
+	Arguments:		CANSparkMax* pSpark
+	Returns:		int - Device handle for Require()
+******************************************************************************/
+int CStatusFramePlanner::AddSpark(CANSparkMax* pSpark)
+{
+	return AddDevice(eCanSparkMax, nullptr, pSpark);
+}
+
+/******************************************************************************
+	Description:	Ask for a signal at least every nPeriod ms. Asking twice
+					keeps the faster of the two.
+	Arguments:		int nDevice, StatusSignal nSignal, int nPeriod (ms)
+	Returns:		Nothing
+******************************************************************************/
+void CStatusFramePlanner::Require(int nDevice, StatusSignal nSignal, int nPeriod)
+{
+	int& nCurrent = m_vDevices[nDevice].m_anSignalPeriod[nSignal];
+	nCurrent = (nCurrent == 0) ? nPeriod : min(nCurrent, nPeriod);
+}
+
+/******************************************************************************
+	Description:	Work out and send every device's status frame periods, then
+					project the bus load before and after
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CStatusFramePlanner::Apply()
+{
+	vector<int> vDefaultPeriods;
+	vector<int> vPlannedPeriods;
+	vDefaultPeriods.push_back(nCanHeartbeatPeriod);
+	vPlannedPeriods.push_back(nCanHeartbeatPeriod);
+
+	for (sCanDevice& Device : m_vDevices)
+	{
+		Plan(Device);
+		Configure(Device);
+
+		int nFrameCount;
+		const sStatusFrame* pFrames = GetFrameTable(Device.m_nType, nFrameCount);
+		for (int i = 0; i < nFrameCount; i++)
+		{
+			vDefaultPeriods.push_back(pFrames[i].m_nDefaultPeriod);
+			vPlannedPeriods.push_back(Device.m_anFramePeriod[i]);
+		}
+
+		// Control frames from the roboRIO don't change with the plan.
+		const int nControlPeriod = (Device.m_nType == eCanSparkMax) ? nSparkControlPeriod : nPhoenixControlPeriod;
+		vDefaultPeriods.push_back(nControlPeriod);
+		vPlannedPeriods.push_back(nControlPeriod);
+	}
+
+	m_dDefaultUtilization	= GetUtilization(vDefaultPeriods);
+	m_dPlannedUtilization	= GetUtilization(vPlannedPeriods);
+	m_nPlannedFramesPerSecond = 0;
+	for (int nPeriod : vPlannedPeriods) m_nPlannedFramesPerSecond += 1000 / nPeriod;
+}
+
+/******************************************************************************
+	Description:	Put the projected bus load on the SmartDashboard
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CStatusFramePlanner::Publish()
+{
+	SmartDashboard::PutNumber("CAN/Devices", m_vDevices.size());
+	SmartDashboard::PutNumber("CAN/Default Utilization (%)", m_dDefaultUtilization * 100.000);
+	SmartDashboard::PutNumber("CAN/Planned Utilization (%)", m_dPlannedUtilization * 100.000);
+	SmartDashboard::PutNumber("CAN/Planned Frames Per Second", m_nPlannedFramesPerSecond);
+}
+
+/******************************************************************************
+	Description:	Worst case length of an extended (29 bit ID) CAN frame,
+					including bit stuffing and the interframe space
+	Arguments:		int nPayloadBytes
+	Returns:		double - Bits on the wire
+******************************************************************************/
+double CStatusFramePlanner::GetFrameBits(int nPayloadBytes)
+{
+	const int nDataBits = 8 * nPayloadBytes;
+	return nDataBits + 67 + ((54 + nDataBits - 1) / 4);
+}
+
+/******************************************************************************
+	Description:	Fraction of the bus used by a set of periodic frames
+	Arguments:		const vector<int>& vPeriods - Frame periods (ms)
+	Returns:		double - Utilization, 1.0 is a saturated bus
+******************************************************************************/
+double CStatusFramePlanner::GetUtilization(const vector<int>& vPeriods)
+{
+	double dFramesPerSecond = 0.000;
+	for (int nPeriod : vPeriods) dFramesPerSecond += 1000.000 / nPeriod;
+	return (dFramesPerSecond * GetFrameBits(nCanPayloadBytes)) / dCanBitRate;
+}
+
+/******************************************************************************
+	Description:	Get the status frame table for a device type
+	Arguments:		CanDeviceType nType, int& nFrameCount - Set to the table size
+	Returns:		const sStatusFrame* - First frame
+******************************************************************************/
+const CStatusFramePlanner::sStatusFrame* CStatusFramePlanner::GetFrameTable(CanDeviceType nType, int& nFrameCount)
+{
+	switch (nType)
+	{
+		case eCanTalonFX:
+			nFrameCount = sizeof(s_aTalonFXFrames) / sizeof(s_aTalonFXFrames[0]);
+			return s_aTalonFXFrames;
+		case eCanTalonSRX:
+			nFrameCount = sizeof(s_aTalonSRXFrames) / sizeof(s_aTalonSRXFrames[0]);
+			return s_aTalonSRXFrames;
+		default:
+			nFrameCount = sizeof(s_aSparkMaxFrames) / sizeof(s_aSparkMaxFrames[0]);
+			return s_aSparkMaxFrames;
+	}
+}
+
+/******************************************************************************
+	Description:	Add a device with nothing required of it yet
+	Arguments:		CanDeviceType nType, BaseTalon* pTalon, CANSparkMax* pSpark
+	Returns:		int - Device handle
+******************************************************************************/
+int CStatusFramePlanner::AddDevice(CanDeviceType nType, BaseTalon* pTalon, CANSparkMax* pSpark)
+{
+	sCanDevice Device = {};
+	Device.m_nType	= nType;
+	Device.m_pTalon	= pTalon;
+	Device.m_pSpark	= pSpark;
+	m_vDevices.push_back(Device);
+	return m_vDevices.size() - 1;
+}
+
+/******************************************************************************
+	Description:	Set each frame to the fastest period any of its signals
+					needs, or its idle period if nothing reads it
+	Arguments:		sCanDevice& Device
+	Returns:		Nothing
+******************************************************************************/
+void CStatusFramePlanner::Plan(sCanDevice& Device)
+{
+	int nFrameCount;
+	const sStatusFrame* pFrames = GetFrameTable(Device.m_nType, nFrameCount);
+	for (int i = 0; i < nFrameCount; i++)
+	{
+		int nPeriod = pFrames[i].m_nIdlePeriod;
+		for (int nSignal = 0; nSignal < eSignalCount; nSignal++)
+		{
+			if ((pFrames[i].m_nSignals & SIGNAL_BIT(nSignal)) && Device.m_anSignalPeriod[nSignal] > 0)
+			{
+				nPeriod = min(nPeriod, Device.m_anSignalPeriod[nSignal]);
+			}
+		}
+		Device.m_anFramePeriod[i] = max(nPeriod, 1);
+	}
+}
+
+/******************************************************************************
+	Description:	Send a device's planned periods to it. Timeouts are zero so
+					RobotInit doesn't block on every frame.
+	Arguments:		const sCanDevice& Device
+	Returns:		Nothing
+******************************************************************************/
+void CStatusFramePlanner::Configure(const sCanDevice& Device)
+{
+	int nFrameCount;
+	const sStatusFrame* pFrames = GetFrameTable(Device.m_nType, nFrameCount);
+	for (int i = 0; i < nFrameCount; i++)
+	{
+		if (Device.m_pTalon != nullptr)
+		{
+			Device.m_pTalon->SetStatusFramePeriod((StatusFrameEnhanced)pFrames[i].m_nFrame, (uint8_t)min(Device.m_anFramePeriod[i], nPhoenixMaxFramePeriod), 0);
+		}
+		else if (Device.m_pSpark != nullptr)
+		{
+			Device.m_pSpark->SetPeriodicFramePeriod((CANSparkMaxLowLevel::PeriodicFrame)pFrames[i].m_nFrame, Device.m_anFramePeriod[i]);
+		}
+	}
+}
@@ -0,0 +1,211 @@
+/******************************************************************************
+	Description:	CTargetTracker implementation
+	Class:			CTargetTracker
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "TargetTracker.h"
+
+#include <algorithm>
+#include <cmath>
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CTargetTracker constructor, init variables
+	Arguments:		CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CTargetTracker::CTargetTracker(CTelemetry* pTelemetry)
+{
+	m_pTelemetry	= pTelemetry;
+	m_nNextID		= 1;
+	m_dLastFrame	= 0.000;
+	m_vCandidates.reserve(nVisionMaxDetections * nTrackerMaxTracks);
+
+	// Register dashboard values.
+	m_nTracksHandle		= m_pTelemetry->RegisterNumber("Tracker Tracks", 0.500);
+	m_nHubTrackHandle	= m_pTelemetry->RegisterNumber("Tracker Hub Track", 0.500);
+}
+
+/******************************************************************************
+	Description:	Fold a frame into the tracks. Does nothing for a frame that
+					was already used.
+	Arguments:		const CVisionPacket* pPacket - Latest packet, may be null
+					double dHeading - Gyro angle when the frame was captured
+					(degrees)
+	Returns:		Nothing
+******************************************************************************/
+void CTargetTracker::Update(const CVisionPacket* pPacket, double dHeading)
+{
+	if ((pPacket == nullptr) || (pPacket->m_dTimestamp <= m_dLastFrame)) return;
+	const double dTime = pPacket->m_dTimestamp;
+	m_dLastFrame = dTime;
+
+	// The back camera looks the other way, its bearings are half a turn around.
+	const CDetectionBatch& Batch = pPacket->m_Batch;
+	const double dCameraHeading = dHeading + ((pPacket->m_kDetectionLocation == eBackCamera) ? 180.000 : 0.000);
+	auto GetBearing = [&](int nDetection) { return dCameraHeading + Batch.GetBearing(nDetection); };
+
+	// Drop tracks that have gone unseen too long before matching against them.
+	Expire(dTime);
+
+	// Every detection and track pair that falls inside the gate, cheapest first. Each track
+	// only looks at the detections of its own class.
+	m_vCandidates.clear();
+	for (int j = 0; j < nTrackerMaxTracks; j++)
+	{
+		const sTargetTrack& Track = m_aTracks[j];
+		if ((Track.m_nID == 0) || (Track.m_kLocation != pPacket->m_kDetectionLocation)) continue;
+
+		const double dPredictedBearing = PredictBearing(Track, dTime);
+		const double dPredictedDepth = PredictDepth(Track, dTime);
+		const sDetectionMask Mask = Batch.MatchClass(Track.m_kClass);
+		for (int i = Mask.Next(0); i >= 0; i = Mask.Next(i + 1))
+		{
+			const double dBearingError = (GetBearing(i) - dPredictedBearing) / dTrackerGateBearing;
+			const double dDepthError = ((Batch.m_anDepth[i] > 0) && (Track.m_dDepth > 0.000)) ? ((Batch.m_anDepth[i] - dPredictedDepth) / dTrackerGateDepth) : 0.000;
+			const double dCost = (dBearingError * dBearingError) + (dDepthError * dDepthError);
+			if (dCost < 1.000) m_vCandidates.push_back({dCost, i, j});
+		}
+	}
+	sort(m_vCandidates.begin(), m_vCandidates.end(), [](const sCandidate& A, const sCandidate& B) { return A.m_dCost < B.m_dCost; });
+
+	// Match greedily, each detection and each track at most once.
+	array<bool, nVisionMaxDetections> abDetectionUsed = {};
+	array<bool, nTrackerMaxTracks> abTrackUsed = {};
+	for (const sCandidate& Candidate : m_vCandidates)
+	{
+		if (abDetectionUsed[Candidate.m_nDetection] || abTrackUsed[Candidate.m_nTrack]) continue;
+		abDetectionUsed[Candidate.m_nDetection] = true;
+		abTrackUsed[Candidate.m_nTrack] = true;
+
+		const int i = Candidate.m_nDetection;
+		sTargetTrack& Track = m_aTracks[Candidate.m_nTrack];
+		const double dDelta = max(dTime - Track.m_dLastSeen, 0.001);
+
+		const double dBearingResidual = GetBearing(i) - PredictBearing(Track, dTime);
+		Track.m_dBearing		= PredictBearing(Track, dTime) + (dTrackerAlpha * dBearingResidual);
+		Track.m_dBearingRate	+= (dTrackerBeta / dDelta) * dBearingResidual;
+		if (Batch.m_anDepth[i] > 0)
+		{
+			if (Track.m_dDepth > 0.000)
+			{
+				const double dDepthResidual = Batch.m_anDepth[i] - PredictDepth(Track, dTime);
+				Track.m_dDepth		= PredictDepth(Track, dTime) + (dTrackerAlpha * dDepthResidual);
+				Track.m_dDepthRate	+= (dTrackerBeta / dDelta) * dDepthResidual;
+			}
+			else Track.m_dDepth = Batch.m_anDepth[i];
+		}
+		Track.m_dWidth		= Batch.m_anWidth[i];
+		Track.m_dLastSeen	= dTime;
+		Track.m_nHits++;
+	}
+
+	// Anything left over starts a new track, in a free slot or over the stalest one.
+	for (int i = 0; i < Batch.m_nCount; i++)
+	{
+		if (abDetectionUsed[i]) continue;
+
+		sTargetTrack* pSlot = &m_aTracks[0];
+		for (sTargetTrack& Track : m_aTracks)
+		{
+			if (Track.m_nID == 0)
+			{
+				pSlot = &Track;
+				break;
+			}
+			if (Track.m_dLastSeen < pSlot->m_dLastSeen) pSlot = &Track;
+		}
+		if ((pSlot->m_nID != 0) && (pSlot->m_dLastSeen >= dTime)) break;		// Table is full of this frame's targets.
+
+		*pSlot				= sTargetTrack();
+		pSlot->m_nID		= m_nNextID++;
+		pSlot->m_kClass		= (DetectionClass)Batch.m_anClass[i];
+		pSlot->m_kLocation	= pPacket->m_kDetectionLocation;
+		pSlot->m_nHits		= 1;
+		pSlot->m_dBearing	= GetBearing(i);
+		pSlot->m_dDepth		= max(Batch.m_anDepth[i], 0);
+		pSlot->m_dWidth		= Batch.m_anWidth[i];
+		pSlot->m_dLastSeen	= dTime;
+	}
+}
+
+/******************************************************************************
+	Description:	Drop tracks that have gone unseen longer than the coast
+					time. Called every loop as well as from Update(), so a
+					track can't outlive the camera going quiet.
+	Arguments:		double dNow - FPGA time (s)
+	Returns:		Nothing
+******************************************************************************/
+void CTargetTracker::Expire(double dNow)
+{
+	for (sTargetTrack& Track : m_aTracks)
+	{
+		if ((Track.m_nID != 0) && ((dNow - Track.m_dLastSeen) > dTrackerCoastTime)) Track = sTargetTrack();
+	}
+}
+
+/******************************************************************************
+	Description:	Forget every track, used when odometry is reset since the
+					bearings are relative to the gyro zero
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTargetTracker::Reset()
+{
+	m_aTracks.fill(sTargetTrack());
+}
+
+/******************************************************************************
+	Description:	Gets the confirmed track of a class to act on, the closest
+					one when there's more than one
+	Arguments:		DetectionClass kClass
+	Returns:		const sTargetTrack* - Null if none is confirmed
+******************************************************************************/
+const sTargetTrack* CTargetTracker::GetBest(DetectionClass kClass) const
+{
+	const sTargetTrack* pBest = nullptr;
+	for (const sTargetTrack& Track : m_aTracks)
+	{
+		if ((Track.m_nID == 0) || (Track.m_kClass != kClass) || (Track.m_nHits < nTrackerConfirmHits)) continue;
+
+		// Tracks without a depth lose to any with one.
+		const double dDepth = (Track.m_dDepth > 0.000) ? Track.m_dDepth : HUGE_VAL;
+		if ((pBest == nullptr) || (dDepth < ((pBest->m_dDepth > 0.000) ? pBest->m_dDepth : HUGE_VAL))) pBest = &Track;
+	}
+	return pBest;
+}
+
+/******************************************************************************
+	Description:	Gets a track by ID, so a caller can stay on one target
+	Arguments:		int nID
+	Returns:		const sTargetTrack* - Null once the track has been dropped
+******************************************************************************/
+const sTargetTrack* CTargetTracker::GetTrack(int nID) const
+{
+	if (nID == 0) return nullptr;
+	for (const sTargetTrack& Track : m_aTracks)
+	{
+		if (Track.m_nID == nID) return &Track;
+	}
+	return nullptr;
+}
+
+/******************************************************************************
+	Description:	Write the track count and the hub's track ID into the
+					telemetry buffer
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTargetTracker::Publish()
+{
+	int nTracks = 0;
+	for (const sTargetTrack& Track : m_aTracks)
+	{
+		if (Track.m_nID != 0) nTracks++;
+	}
+
+	const sTargetTrack* pHub = GetBest(eHub);
+	m_pTelemetry->SetNumber(m_nTracksHandle, nTracks);
+	m_pTelemetry->SetNumber(m_nHubTrackHandle, (pHub != nullptr) ? pHub->m_nID : 0);
+}
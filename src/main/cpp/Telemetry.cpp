@@ -0,0 +1,108 @@
+/******************************************************************************
+	Description:	CTelemetry implementation
+	Class:			CTelemetry
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "Telemetry.h"
+
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <frc/smartdashboard/SmartDashboard.h>
+
+using namespace frc;
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CTelemetry constructor, register our own cost entries
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CTelemetry::CTelemetry()
+{
+	m_nFlushTimeHandle		= RegisterNumber("Telemetry Flush Time (us)", 1.000);
+	m_nPublishCountHandle	= RegisterNumber("Telemetry Published Entries");
+}
+
+/******************************************************************************
+	Description:	CTelemetry destructor
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CTelemetry::~CTelemetry()
+{
+}
+
+/******************************************************************************
+	Description:	Register a number entry. Registering a key twice returns
+					the same handle, so this is safe to call from Init().
+	Arguments:		const char* pszKey - SmartDashboard key
+					double dDeadband - Change needed before republishing
+	Returns:		int - Handle for SetNumber()
+******************************************************************************/
+int CTelemetry::RegisterNumber(const char* pszKey, double dDeadband)
+{
+	return Register(pszKey, dDeadband, false);
+}
+
+/******************************************************************************
+	Description:	Register a boolean entry, published on every change.
+	Arguments:		const char* pszKey - SmartDashboard key
+	Returns:		int - Handle for SetBoolean()
+******************************************************************************/
+int CTelemetry::RegisterBoolean(const char* pszKey)
+{
+	return Register(pszKey, 0.000, true);
+}
+
+/******************************************************************************
+	Description:	Add a new entry to the arrays, or find the existing one
+	Arguments:		const char* pszKey, double dDeadband, bool bBoolean
+	Returns:		int - Handle
+******************************************************************************/
+int CTelemetry::Register(const char* pszKey, double dDeadband, bool bBoolean)
+{
+	for (unsigned int i = 0; i < m_vKeys.size(); i++)
+	{
+		if (m_vKeys[i] == pszKey) return i;
+	}
+
+	m_vKeys.emplace_back(pszKey);
+	m_vEntries.push_back(SmartDashboard::GetEntry(pszKey));
+	m_vValues.push_back(0.000);
+	// NaN never compares within the deadband, so every entry is published on the first flush.
+	m_vPublished.push_back(numeric_limits<double>::quiet_NaN());
+	m_vDeadbands.push_back(dDeadband);
+	m_vBoolean.push_back(bBoolean);
+
+	return m_vKeys.size() - 1;
+}
+
+/******************************************************************************
+	Description:	Publish every entry that changed past its deadband. Called
+					once at the end of RobotPeriodic.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTelemetry::Flush()
+{
+	const auto tStart = chrono::steady_clock::now();
+
+	int nPublished = 0;
+	for (unsigned int i = 0; i < m_vValues.size(); i++)
+	{
+		const double dValue = m_vValues[i];
+		if (fabs(dValue - m_vPublished[i]) <= m_vDeadbands[i]) continue;
+
+		if (m_vBoolean[i])	m_vEntries[i].SetBoolean(dValue != 0.000);
+		else				m_vEntries[i].SetDouble(dValue);
+		m_vPublished[i] = dValue;
+		nPublished++;
+	}
+
+	// The cost of this flush is published on the next one.
+	const auto tEnd = chrono::steady_clock::now();
+	SetNumber(m_nFlushTimeHandle, chrono::duration<double, micro>(tEnd - tStart).count());
+	SetNumber(m_nPublishCountHandle, nPublished);
+}
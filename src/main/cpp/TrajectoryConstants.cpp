@@ -6,8 +6,103 @@
 
 #include "TrajectoryConstants.h"
 
+#include <chrono>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <frc/DriverStation.h>
+#include <frc/Filesystem.h>
+#include <frc/smartdashboard/SmartDashboard.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 
+/******************************************************************************
+    Description:	CTrajectoryConstants constructor, init variables
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CTrajectoryConstants::CTrajectoryConstants()
+{
+	for (int i = 0; i < nPathCount; i++) m_abReady[i] = false;
+	m_bLoaded = false;
+}
+
+/******************************************************************************
+    Description:	CTrajectoryConstants destructor, wait for the warm thread
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CTrajectoryConstants::~CTrajectoryConstants()
+{
+	if (m_WarmThread.joinable()) m_WarmThread.join();
+}
+
+/******************************************************************************
+    Description:	Start loading every deployed trajectory in the background.
+					Called from RobotInit so auto never waits on file I/O.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTrajectoryConstants::WarmCache()
+{
+	if (m_WarmThread.joinable()) return;
+	m_WarmThread = thread(&CTrajectoryConstants::LoadAll, this);
+}
+
+/******************************************************************************
+    Description:	Warm thread, loads every trajectory path and reports how
+					long it took and how much memory the cache holds
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTrajectoryConstants::LoadAll()
+{
+	const auto tStart = chrono::steady_clock::now();
+	size_t nBytes = 0;
+
+	for (Paths nPath : aTrajectoryPaths)
+	{
+		try
+		{
+			m_apCache[nPath] = make_shared<const Trajectory>(LoadTrajectory(GetPathName(nPath)));
+			nBytes += sizeof(Trajectory) + (m_apCache[nPath]->States().size() * sizeof(Trajectory::State));
+			m_abReady[nPath].store(true, memory_order_release);
+		}
+		catch (const exception&)
+		{
+			DriverStation::ReportWarning(string("Trajectory ") + GetPathName(nPath) + " is not deployed");
+		}
+	}
+
+	SmartDashboard::PutNumber("Path Cache Warm Time (ms)", chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count());
+	SmartDashboard::PutNumber("Path Cache Size (KB)", nBytes / 1024.000);
+	m_bLoaded = true;
+}
+
+/******************************************************************************
+    Description:	Get a cached trajectory. Only blocks if auto starts before
+					the warm thread has finished.
+	Arguments:		int nSelection
+	Returns:		shared_ptr<const Trajectory> - nullptr if not deployed
+******************************************************************************/
+shared_ptr<const Trajectory> CTrajectoryConstants::GetTrajectory(int nSelection)
+{
+	// Anything without its own trajectory falls back to the test path, same as GetPathName().
+	int nSlot = eTestPath;
+	for (Paths nPath : aTrajectoryPaths)
+	{
+		if (nPath == nSelection) nSlot = nPath;
+	}
+
+	if (!m_abReady[nSlot].load(memory_order_acquire))
+	{
+		if (m_WarmThread.joinable()) m_WarmThread.join();
+		else if (!m_bLoaded) LoadAll();
+	}
+	return m_abReady[nSlot].load(memory_order_acquire) ? m_apCache[nSlot] : nullptr;
+}
+
 /******************************************************************************
     Description:	Set selected trajectory based on enumerator
 	Arguments:		int nSelection
@@ -15,32 +110,7 @@
 ******************************************************************************/
 void CTrajectoryConstants::SelectTrajectory(int nSelection)
 {
-	Trajectory path;
-	switch(nSelection)
-	{
-		case eTestPath:
-			// Read and store the trajectory from a pre-generated JSON file
-			path = TrajectoryUtil::FromPathweaverJson("/home/lvuser/deploy/paths/output/TestPath.wpilib.json");
-			break;
-
-		case eAdvancement1:
-			// Read and store the trajectory from a pre-generated JSON file
-			path = TrajectoryUtil::FromPathweaverJson("/home/lvuser/deploy/paths/output/Advancement1.wpilib.json");
-			break;
-			
-		case eAdvancement2:
-			// Read and store the trajectory from a pre-generated JSON file
-			path = TrajectoryUtil::FromPathweaverJson("/home/lvuser/deploy/paths/output/Advancement2.wpilib.json");
-			break;
-		
-		default:
-			// Read and store the trajectory from a pre-generated JSON file
-			path = TrajectoryUtil::FromPathweaverJson("/home/lvuser/deploy/paths/output/TestPath.wpilib.json");
-			break;
-	}
-	
-	m_pSelectedPath = (Trajectory*)malloc(sizeof(path) + 1);
-	memcpy(m_pSelectedPath, &path, sizeof(path) + 1);
+	m_pSelectedPath = GetTrajectory(nSelection);
 }
 
 /******************************************************************************
@@ -50,8 +120,126 @@ void CTrajectoryConstants::SelectTrajectory(int nSelection)
 ******************************************************************************/
 void CTrajectoryConstants::SelectTrajectory(Trajectory Path)
 {
-	free(m_pSelectedPath);
-	
-	m_pSelectedPath = (Trajectory*)malloc(sizeof(Path));
-	memcpy(m_pSelectedPath, &Path, sizeof(Path));
+	m_pSelectedPath = make_shared<const Trajectory>(move(Path));
+}
+
+/******************************************************************************
+    Description:	Get the deployed file name for a path
+	Arguments:		int nSelection
+	Returns:		const char* - File name without directory or extension
+******************************************************************************/
+const char* CTrajectoryConstants::GetPathName(int nSelection)
+{
+	switch(nSelection)
+	{
+		case eAdvancement1:		return "Advancement1";
+		case eAdvancement2:		return "Advancement2";
+		case eTestPath:
+		default:				return "TestPath";
+	}
+}
+
+/******************************************************************************
+    Description:	Load a deployed trajectory, preferring the binary table and
+					falling back to parsing the JSON
+	Arguments:		const char* pszName - Path name from GetPathName()
+	Returns:		Trajectory
+******************************************************************************/
+Trajectory CTrajectoryConstants::LoadTrajectory(const char* pszName)
+{
+	Trajectory path;
+	const string strDeploy = frc::filesystem::GetDeployDirectory() + "/";
+	if (LoadBinaryTrajectory(strDeploy + pszPathBinaryDirectory + pszName + ".traj", path)) return path;
+
+	DriverStation::ReportWarning(string("No binary trajectory for ") + pszName + ", parsing JSON");
+	return TrajectoryUtil::FromPathweaverJson(strDeploy + pszPathJsonDirectory + pszName + ".wpilib.json");
+}
+
+/******************************************************************************
+    Description:	Map a binary trajectory file and build the Trajectory
+					straight from its state table
+	Arguments:		const string& strFile, Trajectory& Path
+	Returns:		bool - False if the file is missing or doesn't validate
+******************************************************************************/
+bool CTrajectoryConstants::LoadBinaryTrajectory(const string& strFile, Trajectory& Path)
+{
+	int nFile = open(strFile.c_str(), O_RDONLY);
+	if (nFile < 0) return false;
+
+	struct stat FileStat;
+	if (fstat(nFile, &FileStat) != 0 || FileStat.st_size < (off_t)sizeof(sBinaryTrajectoryHeader))
+	{
+		close(nFile);
+		return false;
+	}
+
+	void* pMapped = mmap(nullptr, FileStat.st_size, PROT_READ, MAP_PRIVATE, nFile, 0);
+	close(nFile);
+	if (pMapped == MAP_FAILED) return false;
+
+	// Divide rather than multiply the count out, a corrupt count can't wrap around and pass.
+	const sBinaryTrajectoryHeader* pHeader = (const sBinaryTrajectoryHeader*)pMapped;
+	const size_t nMaxCount = ((size_t)FileStat.st_size - sizeof(sBinaryTrajectoryHeader)) / sizeof(sBinaryTrajectoryState);
+	const bool bValid = (pHeader->m_nMagic == nBinaryTrajectoryMagic) &&
+						(pHeader->m_nVersion == nBinaryTrajectoryVersion) &&
+						(pHeader->m_nCount > 0) &&
+						(pHeader->m_nCount <= nMaxCount);
+	if (bValid)
+	{
+		const sBinaryTrajectoryState* pStates = (const sBinaryTrajectoryState*)(pHeader + 1);
+		vector<Trajectory::State> vStates;
+		vStates.reserve(pHeader->m_nCount);
+		for (uint32_t i = 0; i < pHeader->m_nCount; i++)
+		{
+			const sBinaryTrajectoryState& State = pStates[i];
+			vStates.push_back(Trajectory::State{
+				second_t(State.m_dTime),
+				meters_per_second_t(State.m_dVelocity),
+				meters_per_second_squared_t(State.m_dAcceleration),
+				Pose2d(meter_t(State.m_dX), meter_t(State.m_dY), Rotation2d(radian_t(State.m_dRotation))),
+				curvature_t(State.m_dCurvature)
+			});
+		}
+		Path = Trajectory(vStates);
+	}
+
+	munmap(pMapped, FileStat.st_size);
+	return bValid;
+}
+
+/******************************************************************************
+    Description:	Time the JSON and binary loaders on every deployed path and
+					put the results on the SmartDashboard. Run from test mode,
+					the JSON parse is far too slow for anywhere near auto.
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTrajectoryConstants::BenchmarkLoaders()
+{
+	const string strDeploy = frc::filesystem::GetDeployDirectory() + "/";
+	for (Paths nPath : aTrajectoryPaths)
+	{
+		const string strName = GetPathName(nPath);
+		Trajectory path;
+
+		auto tStart = chrono::steady_clock::now();
+		const bool bBinary = LoadBinaryTrajectory(strDeploy + pszPathBinaryDirectory + strName + ".traj", path);
+		const double dBinaryTime = chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count();
+
+		double dJsonTime = -1.000;
+		try
+		{
+			tStart = chrono::steady_clock::now();
+			path = TrajectoryUtil::FromPathweaverJson(strDeploy + pszPathJsonDirectory + strName + ".wpilib.json");
+			dJsonTime = chrono::duration<double, milli>(chrono::steady_clock::now() - tStart).count();
+		}
+		catch (const exception&)
+		{
+			// The path isn't deployed, leave the JSON time at -1.
+		}
+
+		SmartDashboard::PutNumber("Path Load/" + strName + " States", path.States().size());
+		SmartDashboard::PutNumber("Path Load/" + strName + " JSON (ms)", dJsonTime);
+		SmartDashboard::PutNumber("Path Load/" + strName + " Binary (ms)", bBinary ? dBinaryTime : -1.000);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+/******************************************************************************
+	Description:	CTrajectoryFollower implementation
+	Class:			CTrajectoryFollower
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "TrajectoryFollower.h"
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CTrajectoryFollower constructor, init variables
+	Arguments:		DifferentialDriveKinematics Kinematics
+					SimpleMotorFeedforward<meters> Feedforward
+					double dProportional, double dIntegral, double dDerivative
+					second_t dPeriod - How often Calculate() is called
+					CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CTrajectoryFollower::CTrajectoryFollower(DifferentialDriveKinematics Kinematics, SimpleMotorFeedforward<meters> Feedforward, double dProportional, double dIntegral, double dDerivative, second_t dPeriod, CTelemetry* pTelemetry) :
+	m_Kinematics(Kinematics),
+	m_Feedforward(Feedforward),
+	m_LeftController(dProportional, dIntegral, dDerivative, dPeriod),
+	m_RightController(dProportional, dIntegral, dDerivative, dPeriod)
+{
+	m_pTrajectory			= nullptr;
+	m_dPrevTime				= -1_s;
+	m_pTelemetry			= pTelemetry;
+
+	// Register dashboard values.
+	m_nErrorXHandle			= m_pTelemetry->RegisterNumber("Follower X Error (m)", 0.005);
+	m_nErrorYHandle			= m_pTelemetry->RegisterNumber("Follower Y Error (m)", 0.005);
+	m_nErrorHeadingHandle	= m_pTelemetry->RegisterNumber("Follower Heading Error (deg)", 0.100);
+	m_nLeftSpeedErrorHandle	= m_pTelemetry->RegisterNumber("Follower Left Speed Error (mps)", 0.010);
+	m_nRightSpeedErrorHandle= m_pTelemetry->RegisterNumber("Follower Right Speed Error (mps)", 0.010);
+}
+
+/******************************************************************************
+	Description:	Load a trajectory to follow. The clock starts on the first
+					Calculate(), so it doesn't matter how long after arming the
+					robot starts moving.
+	Arguments:		shared_ptr<const Trajectory> pTrajectory
+	Returns:		Nothing
+******************************************************************************/
+void CTrajectoryFollower::Arm(shared_ptr<const Trajectory> pTrajectory)
+{
+	m_pTrajectory	= move(pTrajectory);
+	m_dPrevTime		= -1_s;
+	m_Timer.Stop();
+	m_Timer.Reset();
+	m_LeftController.Reset();
+	m_RightController.Reset();
+	if (m_pTrajectory == nullptr) return;
+
+	const Trajectory::State InitialState = m_pTrajectory->Sample(0_s);
+	m_PrevSpeeds = m_Kinematics.ToWheelSpeeds(ChassisSpeeds{InitialState.velocity, 0_mps, InitialState.velocity * InitialState.curvature});
+}
+
+/******************************************************************************
+	Description:	Drop the current trajectory
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CTrajectoryFollower::Disarm()
+{
+	Arm(nullptr);
+}
+
+/******************************************************************************
+	Description:	Work out the drive voltages for this tick and publish the
+					tracking error. Outputs zero if nothing is armed.
+	Arguments:		const Pose2d& Pose - Current odometry pose
+					const DifferentialDriveWheelSpeeds& ActualSpeeds
+					volt_t& dLeftVoltage, volt_t& dRightVoltage - Outputs
+	Returns:		Nothing
+******************************************************************************/
+void CTrajectoryFollower::Calculate(const Pose2d& Pose, const DifferentialDriveWheelSpeeds& ActualSpeeds, volt_t& dLeftVoltage, volt_t& dRightVoltage)
+{
+	dLeftVoltage	= 0_V;
+	dRightVoltage	= 0_V;
+	if (m_pTrajectory == nullptr) return;
+
+	// First tick after arming, start the clock and hold still like RamseteCommand does.
+	if (m_dPrevTime < 0_s)
+	{
+		m_Timer.Reset();
+		m_Timer.Start();
+		m_dPrevTime = 0_s;
+		return;
+	}
+
+	const second_t dTime	= m_Timer.Get();
+	const second_t dDelta	= dTime - m_dPrevTime;
+	if (dDelta <= 0_s) return;
+
+	const Trajectory::State DesiredState = m_pTrajectory->Sample(dTime);
+	const DifferentialDriveWheelSpeeds TargetSpeeds = m_Kinematics.ToWheelSpeeds(m_Controller.Calculate(Pose, DesiredState));
+
+	const volt_t dLeftFeedforward	= m_Feedforward.Calculate(TargetSpeeds.left, (TargetSpeeds.left - m_PrevSpeeds.left) / dDelta);
+	const volt_t dRightFeedforward	= m_Feedforward.Calculate(TargetSpeeds.right, (TargetSpeeds.right - m_PrevSpeeds.right) / dDelta);
+	dLeftVoltage	= volt_t(m_LeftController.Calculate(ActualSpeeds.left.value(), TargetSpeeds.left.value())) + dLeftFeedforward;
+	dRightVoltage	= volt_t(m_RightController.Calculate(ActualSpeeds.right.value(), TargetSpeeds.right.value())) + dRightFeedforward;
+
+	m_PrevSpeeds	= TargetSpeeds;
+	m_dPrevTime		= dTime;
+
+	// Tracking error in the robot's frame, the same error the Ramsete controller is correcting.
+	const Pose2d PoseError = DesiredState.pose.RelativeTo(Pose);
+	m_pTelemetry->SetNumber(m_nErrorXHandle, PoseError.X().value());
+	m_pTelemetry->SetNumber(m_nErrorYHandle, PoseError.Y().value());
+	m_pTelemetry->SetNumber(m_nErrorHeadingHandle, PoseError.Rotation().Degrees().value());
+	m_pTelemetry->SetNumber(m_nLeftSpeedErrorHandle, (TargetSpeeds.left - ActualSpeeds.left).value());
+	m_pTelemetry->SetNumber(m_nRightSpeedErrorHandle, (TargetSpeeds.right - ActualSpeeds.right).value());
+}
+
+/******************************************************************************
+	Description:	Returns bool on whether the trajectory has finished
+	Arguments:		None
+	Returns:		bool - True once the trajectory's time has elapsed, or if
+					nothing is armed
+******************************************************************************/
+bool CTrajectoryFollower::IsFinished()
+{
+	if (m_pTrajectory == nullptr) return true;
+	return (m_dPrevTime >= 0_s) && m_Timer.HasElapsed(m_pTrajectory->TotalTime());
+}
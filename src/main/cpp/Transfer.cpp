@@ -6,6 +6,7 @@
 ******************************************************************************/
 
 #include "Transfer.h"
+#include "LoopProfiler.h"
 
 #include <frc/smartdashboard/SmartDashboard.h>
 
@@ -13,11 +14,16 @@
 
 /******************************************************************************
 	Description:	CTransfer constructor, init variables
-	Arguments:		None
+	Arguments:		const sSensorSnapshot* pSnapshot
+					CCommandCache* pCommandCache
 	Derived from:	Nothing
 ******************************************************************************/
-CTransfer::CTransfer()
+CTransfer::CTransfer(const sSensorSnapshot* pSnapshot, CCommandCache* pCommandCache)
 {
+	m_pSnapshot			= pSnapshot;
+	m_pCommandCache		= pCommandCache;
+	m_nTopCommand		= m_pCommandCache->Register();
+	m_nBackCommand		= m_pCommandCache->Register();
 	m_pTopMotor			= new CANSparkMax(nTransferVertical, CANSparkMaxLowLevel::MotorType::kBrushless);
 	m_pBackMotor		= new CANSparkMax(nTransferBack, CANSparkMaxLowLevel::MotorType::kBrushless);
 	m_pTopInfrared		= new DigitalInput(nTopTransferInfrared);
@@ -76,7 +82,7 @@ void CTransfer::Init()
 ******************************************************************************/
 void CTransfer::StartVertical()
 {
-	m_pTopMotor->Set(-0.225);
+	m_pCommandCache->Set(m_nTopCommand, m_pTopMotor, -0.225);
 }
 
 /******************************************************************************
@@ -85,7 +91,7 @@ void CTransfer::StartVertical()
 	Returns:		Nothing
 ******************************************************************************/
 void CTransfer::StartVerticalShot() {
-	m_pTopMotor->Set(-0.750);
+	m_pCommandCache->Set(m_nTopCommand, m_pTopMotor, -0.750);
 }
 
 /******************************************************************************
@@ -95,7 +101,7 @@ void CTransfer::StartVerticalShot() {
 ******************************************************************************/
 void CTransfer::StartBack()
 {
-	m_pBackMotor->Set(0.500);
+	m_pCommandCache->Set(m_nBackCommand, m_pBackMotor, 0.500);
 }
 
 /******************************************************************************
@@ -105,7 +111,7 @@ void CTransfer::StartBack()
 ******************************************************************************/
 void CTransfer::StopVertical()
 {
-	m_pTopMotor->Set(0.000);
+	m_pCommandCache->Set(m_nTopCommand, m_pTopMotor, 0.000);
 }
 
 /******************************************************************************
@@ -115,7 +121,7 @@ void CTransfer::StopVertical()
 ******************************************************************************/
 void CTransfer::StopBack()
 {
-	m_pBackMotor->Set(0.000);
+	m_pCommandCache->Set(m_nBackCommand, m_pBackMotor, 0.000);
 }
 
 /******************************************************************************
@@ -125,6 +131,31 @@ void CTransfer::StopBack()
 ******************************************************************************/
 void CTransfer::UpdateLocations()
 {
-	m_aBallLocations[0] = m_pTopDebouncer->Calculate(!m_pTopInfrared->Get());	
-	m_aBallLocations[1] = m_pBackDebouncer->Calculate(!m_pBackInfrared->Get());
+	PROFILE_SCOPE(eProfileTransferUpdate);
+	m_aBallLocations[0] = m_pTopDebouncer->Calculate(m_pSnapshot->m_bVerticalInfrared);	
+	m_aBallLocations[1] = m_pBackDebouncer->Calculate(m_pSnapshot->m_bBackInfrared);
+}
+
+/******************************************************************************
+	Description:	Reads both infrared sensors into the loop's sensor snapshot
+	Arguments:		sSensorSnapshot& Snapshot
+	Returns:		Nothing
+******************************************************************************/
+void CTransfer::ReadSensors(sSensorSnapshot& Snapshot)
+{
+	Snapshot.m_bVerticalInfrared	= !m_pTopInfrared->Get();
+	Snapshot.m_bBackInfrared		= !m_pBackInfrared->Get();
+}
+
+/******************************************************************************
+	Description:	Declare the CAN signals the transfer reads. The infrared
+					sensors are on the roboRIO, so nothing is read from either
+					motor.
+	Arguments:		CStatusFramePlanner* pPlanner
+	Returns:		Nothing
+******************************************************************************/
+void CTransfer::ConfigureStatusFrames(CStatusFramePlanner* pPlanner)
+{
+	pPlanner->AddSpark(m_pTopMotor);
+	pPlanner->AddSpark(m_pBackMotor);
 }
\ No newline at end of file
@@ -5,65 +5,343 @@
 ******************************************************************************/
 
 #include "Vision.h"
-#include <fmt/core.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
 #include <frc/smartdashboard/SmartDashboard.h>
-#include <frc/DriverStation.h>
 
 using namespace frc;
 using namespace std;
-///////////////////////////////////////////////////////////////////////////////
 
-CVisionPacket::CVisionPacket(const char* pPacketArr, unsigned int length)
-{
-	// Allocate the packet data
-	m_pRawPacket = (char*)malloc(length);
-	// Copy the packet (allocated on the stack) to a new array.
-	memcpy((void*)m_pRawPacket, (void*)pPacketArr, length);
-	
-	// Read in the actual data from the packet.
-	m_nRandVal = m_pRawPacket[0];
-	m_nDetectionCount = m_pRawPacket[1];
-	m_kDetectionLocation = (DetectionLocation)m_pRawPacket[2];
-}
+// CDetectionBatch reads confidence, class and depth out of the last eight bytes of a record.
+static_assert((nVisionDetectionConfidence == 8) && (nVisionDetectionClass == 9) && (nVisionDetectionDepth == nVisionProtocolDetectionSize - 4), "Version 2 detection tail");
+static_assert(nVisionDetectionSize - 4 == 10, "Version 1 detection tail");
+///////////////////////////////////////////////////////////////////////////////
 
 CVisionPacket::CVisionPacket()
 {
 	m_nRandVal = 0xFF;
 	m_nDetectionCount = 0xFF;
 	m_kDetectionLocation = DetectionLocation::eNONE;
-	m_pDetections = nullptr;
-	m_pRawPacket = nullptr;
- }
-
-CVisionPacket::~CVisionPacket()
-{
-	free(m_pRawPacket);
+	m_nVersion = 0;
+	m_nSequence = 0;
+	m_nCaptureTime = 0;
+	m_nRawLength = 0;
 }
 
-CVisionPacket* CVisionPacket::GetReceivedPacket() {
-	// Retrive the processed vision packet from our coprocessor.
-	string processed_vision = SmartDashboard::GetRaw("processed_vision", "");
+/******************************************************************************
+    Description:	Copy a raw packet into this packet's fixed buffer and read
+					the header. Version 2 packets are checked whole, length
+					and CRC, and rejected if anything is off. Anything else is
+					read as a version 1 packet, truncated to the buffer.
+	Arguments:		const char* pPacketArr, unsigned int nLength
+	Returns:		bool - True if the packet holds a valid header
+******************************************************************************/
+bool CVisionPacket::Decode(const char* pPacketArr, unsigned int nLength)
+{
+	const unsigned char* pData = (const unsigned char*)pPacketArr;
+	if((nLength >= sizeof(nVisionProtocolMagic)) && (LoadBigEndian16(pData) == nVisionProtocolMagic)) {
+		CVisionPacketView View(pData, nLength);
+		if(!View.Validate()) {
+			m_nRandVal = 0xFF;
+			return false;
+		}
+		m_nRawLength = nLength;
+		memcpy(m_aRawPacket, pData, m_nRawLength);
 
-	if(!processed_vision.empty()) {
-		const char* pVisionPacketArr = processed_vision.c_str();
-		CVisionPacket* pVisionPacket = new CVisionPacket(pVisionPacketArr, processed_vision.length());
+		m_nVersion = nVisionProtocolVersion;
+		m_nSequence = View.GetSequence();
+		m_nCaptureTime = View.GetCaptureTime();
+		m_nDetectionCount = (unsigned char)View.GetDetectionCount();
+		m_kDetectionLocation = (DetectionLocation)View.GetLocation();
+		// Keep the old change check working, consecutive sequences never repeat or hit 0xFF.
+		m_nRandVal = (unsigned char)(m_nSequence % 0xFF);
+		return true;
+	}
 
-		if(pVisionPacket->m_nRandVal != 0xFF) {
-			return pVisionPacket;
-		}
+	m_nRawLength = min(nLength, (unsigned int)nVisionMaxPacketSize);
+	if(m_nRawLength < (unsigned int)nVisionHeaderSize) {
+		m_nRandVal = 0xFF;
+		return false;
 	}
+	memcpy(m_aRawPacket, pPacketArr, m_nRawLength);
+
+	// Read in the actual data from the packet.
+	m_nVersion = 1;
+	m_nSequence = 0;
+	m_nCaptureTime = 0;
+	m_nRandVal = m_aRawPacket[0];
+	m_nDetectionCount = m_aRawPacket[1];
+	m_kDetectionLocation = (DetectionLocation)m_aRawPacket[2];
+
+	// Never trust the count further than the bytes we actually received.
+	const unsigned int nAvailable = (m_nRawLength - nVisionHeaderSize) / nVisionDetectionSize;
+	if(m_nDetectionCount > nAvailable) m_nDetectionCount = nAvailable;
 
-	return nullptr;
+	return m_nRandVal != 0xFF;
 }
 
+/******************************************************************************
+    Description:	Decode the detections of the last packet passed to Decode()
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
 void CVisionPacket::ParseDetections()
 {
-	m_kDetectionLocation = (DetectionLocation)m_pRawPacket[0];
-	// Preallocate the array
-	m_pDetections = (sObjectDetection**)malloc(m_nDetectionCount * sizeof(sObjectDetection));
+	if(m_nVersion == nVisionProtocolVersion) {
+		const CVisionPacketView View(m_aRawPacket, m_nRawLength);
+		for(int i = 0; i < m_nDetectionCount; i++) m_aDetections[i].Decode(View, i);
+		return;
+	}
+
 	for(int i = 0; i < m_nDetectionCount; i++) {
 		// Get the offset that we are into the packet.
-		int packetOffset = 3 + (i * sizeof(sObjectDetection));
-		m_pDetections[i] = new sObjectDetection(m_pRawPacket, packetOffset);
+		int packetOffset = nVisionHeaderSize + (i * nVisionDetectionSize);
+		m_aDetections[i].Decode(m_aRawPacket, packetOffset);
+	}
+}
+
+/******************************************************************************
+    Description:	Decode the detections of the last packet passed to Decode()
+					into m_Batch
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CVisionPacket::ParseBatch()
+{
+	const int nHeader = (m_nVersion == nVisionProtocolVersion) ? nVisionProtocolHeaderSize : nVisionHeaderSize;
+	m_Batch.Decode(m_aRawPacket + nHeader, m_nVersion, m_nDetectionCount);
+}
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CDetectionBatch constructor, init variables
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CDetectionBatch::CDetectionBatch()
+{
+	m_nCount = 0;
+	memset(m_anX, 0, sizeof(m_anX));
+	memset(m_anY, 0, sizeof(m_anY));
+	memset(m_anWidth, 0, sizeof(m_anWidth));
+	memset(m_anHeight, 0, sizeof(m_anHeight));
+	memset(m_anConfidence, 0, sizeof(m_anConfidence));
+	memset(m_anClass, 0, sizeof(m_anClass));
+	memset(m_anDepth, 0, sizeof(m_anDepth));
+}
+
+/******************************************************************************
+	Description:	Decode a packet's detection records
+	Arguments:		const unsigned char* pDetections - First record
+					int nVersion - Wire protocol version, sets the record size
+					int nCount - Records, already checked against the packet
+					length
+	Returns:		Nothing
+******************************************************************************/
+void CDetectionBatch::Decode(const unsigned char* pDetections, int nVersion, int nCount)
+{
+	m_nCount = min(nCount, nVisionMaxDetections);
+	if (nVersion == nVisionProtocolVersion) DecodeRecords<nVisionProtocolDetectionSize>(pDetections, m_nCount);
+	else DecodeRecords<nVisionDetectionSize>(pDetections, m_nCount);
+}
+
+/******************************************************************************
+	Description:	One pass over the records. The first load holds x, y, width
+					and height, the second ends on the record's last byte and
+					holds confidence, class and depth, so every field is a
+					shift of one of two byte swapped words.
+	Arguments:		const unsigned char* pDetections, int nCount
+	Returns:		Nothing
+******************************************************************************/
+template<int nStride> void CDetectionBatch::DecodeRecords(const unsigned char* pDetections, int nCount)
+{
+	const int nClassShift = (nStride - 10) * 8;
+	for (int i = 0; i < nCount; i++)
+	{
+		const unsigned char* pRecord = pDetections + (i * nStride);
+		const uint64_t nFirst	= LoadBigEndian64(pRecord);
+		const uint64_t nSecond	= LoadBigEndian64(pRecord + nStride - 8);
+		m_anX[i]			= (uint16_t)(nFirst >> 48);
+		m_anY[i]			= (uint16_t)(nFirst >> 32);
+		m_anWidth[i]		= (uint16_t)(nFirst >> 16);
+		m_anHeight[i]		= (uint16_t)nFirst;
+		m_anConfidence[i]	= (uint8_t)(nSecond >> (nClassShift + 8));
+		m_anClass[i]		= (uint8_t)(nSecond >> nClassShift);
+		// Version 1 sends a signed depth, version 2 an unsigned one.
+		m_anDepth[i]		= (nStride == nVisionProtocolDetectionSize) ? (int32_t)min<uint32_t>((uint32_t)nSecond, INT32_MAX) : (int32_t)(uint32_t)nSecond;
 	}
-}
\ No newline at end of file
+}
+
+/******************************************************************************
+	Description:	Mark every detection that matches
+	Arguments:		Predicate Match - bool(int nIndex), no branches inside
+	Returns:		sDetectionMask
+******************************************************************************/
+template<typename Predicate> sDetectionMask CDetectionBatch::BuildMask(Predicate Match) const
+{
+	// Entries past the count are left over from earlier packets, their results are never read.
+	sDetectionMask Mask;
+	Mask.m_nCount = m_nCount;
+	for (int i = 0; i < nDetectionBatchCapacity; i++) Mask.m_anMatch[i] = (uint8_t)Match(i);
+	return Mask;
+}
+
+/******************************************************************************
+	Description:	Detections of one class
+	Arguments:		DetectionClass kClass
+	Returns:		sDetectionMask
+******************************************************************************/
+sDetectionMask CDetectionBatch::MatchClass(DetectionClass kClass) const
+{
+	return BuildMask([&](int i) { return m_anClass[i] == kClass; });
+}
+
+/******************************************************************************
+	Description:	Detections at or above a confidence
+	Arguments:		uint8_t nMinimum - 255 is certain
+	Returns:		sDetectionMask
+******************************************************************************/
+sDetectionMask CDetectionBatch::MatchConfidence(uint8_t nMinimum) const
+{
+	return BuildMask([&](int i) { return m_anConfidence[i] >= nMinimum; });
+}
+
+/******************************************************************************
+	Description:	Detections whose center falls inside a bearing window. The
+					window is turned into whole pixels once, so the kernel
+					only compares integers.
+	Arguments:		double dMinimum, double dMaximum - Degrees right of the
+					camera's center
+	Returns:		sDetectionMask
+******************************************************************************/
+sDetectionMask CDetectionBatch::MatchBearing(double dMinimum, double dMaximum) const
+{
+	const double dLow	= max(ceil(160.000 + (dMinimum / dAnglePerPixel)), 0.000);
+	const double dHigh	= min(floor(160.000 + (dMaximum / dAnglePerPixel)), 65535.000);
+	if (dHigh < dLow) return BuildMask([](int) { return false; });
+
+	// Same width as the field, so the compares stay 16 bit lanes.
+	const uint16_t nLow		= (uint16_t)dLow;
+	const uint16_t nHigh	= (uint16_t)dHigh;
+	return BuildMask([&](int i) { return (m_anX[i] >= nLow) & (m_anX[i] <= nHigh); });
+}
+
+/******************************************************************************
+	Description:	Build a version 2 packet of made up detections for
+					Benchmark()
+	Arguments:		int nCount, vector<unsigned char>& vPacket - Filled in
+	Returns:		Nothing
+******************************************************************************/
+static void BuildBenchmarkPacket(int nCount, vector<unsigned char>& vPacket)
+{
+	vPacket.assign(nVisionProtocolHeaderSize + (nCount * nVisionProtocolDetectionSize) + nVisionProtocolTrailerSize, 0);
+	auto Store = [&](int nOffset, uint64_t nValue, int nBytes)
+	{
+		for (int n = 0; n < nBytes; n++) vPacket[nOffset + n] = (unsigned char)(nValue >> (8 * (nBytes - 1 - n)));
+	};
+
+	Store(nVisionHeaderMagic, nVisionProtocolMagic, 2);
+	Store(nVisionHeaderVersion, nVisionProtocolVersion, 1);
+	Store(nVisionHeaderCount, nCount, 2);
+	Store(nVisionHeaderDetectionSize, nVisionProtocolDetectionSize, 2);
+	for (int i = 0; i < nCount; i++)
+	{
+		const int nRecord = nVisionProtocolHeaderSize + (i * nVisionProtocolDetectionSize);
+		Store(nRecord + nVisionDetectionX, (i * 37) % 320, 2);
+		Store(nRecord + nVisionDetectionY, (i * 53) % 240, 2);
+		Store(nRecord + nVisionDetectionWidth, 20 + (i % 40), 2);
+		Store(nRecord + nVisionDetectionHeight, 20 + (i % 30), 2);
+		Store(nRecord + nVisionDetectionConfidence, (i * 97) & 0xFF, 1);
+		Store(nRecord + nVisionDetectionClass, i % 4, 1);
+		Store(nRecord + nVisionDetectionDepth, 1000 + (i * 10), 4);
+	}
+	const int nBody = (int)vPacket.size() - nVisionProtocolTrailerSize;
+	Store(nBody, VisionCrc32(vPacket.data(), nBody), 4);
+}
+
+/******************************************************************************
+	Description:	Time ParseDetections() against ParseBatch(), and a scan per
+					class against the filter kernels, on packets of 1, 16 and
+					255 detections. Results go to the dashboard. Run from
+					TestInit().
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CDetectionBatch::Benchmark()
+{
+	const int nIterations = 2000;
+	const uint8_t nMinConfidence = 128;
+	const double dWindow = 20.000;		// Degrees either side of center.
+	const DetectionClass akClasses[] = {eHub, eRedCargo, eBlueCargo};
+
+	CVisionPacket* pPacket = new CVisionPacket();
+	vector<unsigned char> vPacket;
+	bool bAgree = true;
+	for (int nCount : {1, 16, nVisionMaxDetections})
+	{
+		BuildBenchmarkPacket(nCount, vPacket);
+		if (!pPacket->Decode((const char*)vPacket.data(), vPacket.size())) bAgree = false;
+		auto GetTime = [&](chrono::steady_clock::time_point tStart) { return chrono::duration<double, micro>(chrono::steady_clock::now() - tStart).count() / nIterations; };
+
+		auto tStart = chrono::steady_clock::now();
+		for (int n = 0; n < nIterations; n++) pPacket->ParseDetections();
+		const double dArrayTime = GetTime(tStart);
+
+		tStart = chrono::steady_clock::now();
+		for (int n = 0; n < nIterations; n++) pPacket->ParseBatch();
+		const double dBatchTime = GetTime(tStart);
+		for (int i = 0; i < nCount; i++)
+		{
+			const CVisionPacket::sObjectDetection& Detection = pPacket->m_aDetections[i];
+			const CDetectionBatch& Batch = pPacket->m_Batch;
+			if ((Detection.m_nX != Batch.m_anX[i]) || (Detection.m_nY != Batch.m_anY[i]) || (Detection.m_nWidth != Batch.m_anWidth[i]) || (Detection.m_nHeight != Batch.m_anHeight[i])
+				|| (Detection.m_nConfidence != Batch.m_anConfidence[i]) || (Detection.m_kClass != Batch.m_anClass[i]) || (Detection.m_nDepth != Batch.m_anDepth[i])) bAgree = false;
+		}
+
+		// The same question both ways, each class in the window above the confidence.
+		int nArrayMatches = 0;
+		tStart = chrono::steady_clock::now();
+		for (int n = 0; n < nIterations; n++)
+		{
+			for (DetectionClass kClass : akClasses)
+			{
+				for (int i = 0; i < pPacket->m_nDetectionCount; i++)
+				{
+					const CVisionPacket::sObjectDetection& Detection = pPacket->m_aDetections[i];
+					const double dBearing = (Detection.m_nX - 160) * dAnglePerPixel;
+					if ((Detection.m_kClass == kClass) && (Detection.m_nConfidence >= nMinConfidence) && (fabs(dBearing) <= dWindow)) nArrayMatches++;
+				}
+			}
+		}
+		const double dArrayFilterTime = GetTime(tStart);
+
+		int nBatchMatches = 0;
+		const CDetectionBatch& Batch = pPacket->m_Batch;
+		tStart = chrono::steady_clock::now();
+		for (int n = 0; n < nIterations; n++)
+		{
+			const sDetectionMask Window = Batch.MatchConfidence(nMinConfidence) & Batch.MatchBearing(-dWindow, dWindow);
+			for (DetectionClass kClass : akClasses)
+			{
+				const sDetectionMask Mask = Batch.MatchClass(kClass) & Window;
+				for (int i = Mask.Next(0); i >= 0; i = Mask.Next(i + 1)) nBatchMatches++;
+			}
+		}
+		const double dBatchFilterTime = GetTime(tStart);
+		if (nArrayMatches != nBatchMatches) bAgree = false;
+
+		const string strName = "Vision Decode/" + to_string(nCount) + " Detections";
+		SmartDashboard::PutNumber(strName + " Array (us)", dArrayTime);
+		SmartDashboard::PutNumber(strName + " Batch (us)", dBatchTime);
+		SmartDashboard::PutNumber(strName + " Array Filter (us)", dArrayFilterTime);
+		SmartDashboard::PutNumber(strName + " Batch Filter (us)", dBatchFilterTime);
+	}
+	SmartDashboard::PutBoolean("Vision Decode/Results Agree", bAgree);
+
+	delete pPacket;
+	pPacket = nullptr;
+}
@@ -0,0 +1,231 @@
+/******************************************************************************
+	Description:	CVisionIngest implementation
+	Class:			CVisionIngest
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "VisionIngest.h"
+
+#include <cmath>
+#include <networktables/NetworkTableInstance.h>
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CVisionIngest constructor, init variables
+	Arguments:		CTelemetry* pTelemetry
+	Derived from:	Nothing
+******************************************************************************/
+CVisionIngest::CVisionIngest(CTelemetry* pTelemetry)
+{
+	m_pTelemetry	= pTelemetry;
+	m_bRunning		= false;
+	m_bHasPacket	= false;
+	m_hPoller		= 0;
+	m_hListener		= 0;
+	m_dIntervalM2	= 0.000;
+	m_nLastChange	= 0;
+	m_nLastSequence	= 0;
+	m_bHasSequence	= false;
+	m_nClockOffset	= 0;
+	m_bHasClockOffset	= false;
+
+	m_nFramesHandle			= m_pTelemetry->RegisterNumber("Vision Frames");
+	m_nRejectedHandle		= m_pTelemetry->RegisterNumber("Vision Frames Rejected");
+	m_nDroppedHandle		= m_pTelemetry->RegisterNumber("Vision Frames Dropped");
+	m_nLatencyMeanHandle	= m_pTelemetry->RegisterNumber("Vision Latency Mean (us)", 10.000);
+	m_nLatencyMaxHandle		= m_pTelemetry->RegisterNumber("Vision Latency Max (us)");
+	m_nIntervalMeanHandle	= m_pTelemetry->RegisterNumber("Vision Interval Mean (us)", 10.000);
+	m_nIntervalJitterHandle	= m_pTelemetry->RegisterNumber("Vision Interval Jitter (us)", 10.000);
+}
+
+/******************************************************************************
+	Description:	CVisionIngest destructor, stop the ingest thread
+	Arguments:		None
+	Derived from:	Nothing
+******************************************************************************/
+CVisionIngest::~CVisionIngest()
+{
+	Stop();
+}
+
+/******************************************************************************
+	Description:	Subscribe to the processed vision entry and start the
+					ingest thread
+	Arguments:		nt::NetworkTableInstance Instance - The robot's default
+					instance unless a test brings its own
+	Returns:		Nothing
+******************************************************************************/
+void CVisionIngest::Start(nt::NetworkTableInstance Instance)
+{
+	if (m_bRunning) return;
+
+	m_Entry		= Instance.GetEntry("/SmartDashboard/processed_vision");
+	m_hPoller	= nt::CreateEntryListenerPoller(Instance.GetHandle());
+	m_hListener	= nt::AddPolledEntryListener(m_hPoller, m_Entry.GetHandle(), NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE | NT_NOTIFY_LOCAL);
+
+	m_bRunning	= true;
+	m_Thread	= thread(&CVisionIngest::IngestThread, this);
+}
+
+/******************************************************************************
+	Description:	Wake up and join the ingest thread
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CVisionIngest::Stop()
+{
+	if (!m_bRunning) return;
+
+	m_bRunning = false;
+	nt::CancelPollEntryListener(m_hPoller);
+	if (m_Thread.joinable()) m_Thread.join();
+
+	nt::RemoveEntryListener(m_hListener);
+	nt::DestroyEntryListenerPoller(m_hPoller);
+}
+
+/******************************************************************************
+	Description:	Get the newest decoded packet. This only swaps an index, the
+					returned packet stays valid until the next call.
+	Arguments:		None
+	Returns:		const CVisionPacket* - nullptr until a packet is received
+******************************************************************************/
+const CVisionPacket* CVisionIngest::GetLatestPacket()
+{
+	if (m_LatestPacket.Update()) m_bHasPacket = true;
+	return m_bHasPacket ? &m_LatestPacket.GetReadBuffer() : nullptr;
+}
+
+/******************************************************************************
+	Description:	Write the ingest latency and jitter into the telemetry buffer
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CVisionIngest::PublishStatistics()
+{
+	m_Statistics.Update();
+	const sIngestStatistics& Statistics = m_Statistics.GetReadBuffer();
+
+	m_pTelemetry->SetNumber(m_nFramesHandle, Statistics.m_nFrames);
+	m_pTelemetry->SetNumber(m_nRejectedHandle, Statistics.m_nRejected);
+	m_pTelemetry->SetNumber(m_nDroppedHandle, Statistics.m_nDropped);
+	m_pTelemetry->SetNumber(m_nLatencyMeanHandle, Statistics.m_dLatencyMean);
+	m_pTelemetry->SetNumber(m_nLatencyMaxHandle, Statistics.m_dLatencyMax);
+	m_pTelemetry->SetNumber(m_nIntervalMeanHandle, Statistics.m_dIntervalMean);
+	m_pTelemetry->SetNumber(m_nIntervalJitterHandle, Statistics.m_dIntervalJitter);
+}
+
+/******************************************************************************
+	Description:	Ingest thread, blocks on the entry listener and decodes
+					every raw value it is handed
+	Arguments:		None
+	Returns:		Nothing
+******************************************************************************/
+void CVisionIngest::IngestThread()
+{
+	while (m_bRunning)
+	{
+		bool bTimedOut = false;
+		vector<nt::EntryNotification> vNotifications = nt::PollEntryListener(m_hPoller, 0.500, &bTimedOut);
+
+		for (const nt::EntryNotification& Notification : vNotifications)
+		{
+			if (!Notification.value || !Notification.value->IsRaw()) continue;
+
+			// Decode straight into the write buffer, it is ours until it gets published.
+			std::string_view strRaw	= Notification.value->GetRaw();
+			CVisionPacket& Packet	= m_LatestPacket.GetWriteBuffer();
+			if (!Packet.Decode(strRaw.data(), strRaw.size()))
+			{
+				// Publish here too, a coprocessor sending nothing but bad packets never reaches RecordFrame().
+				m_RunningStatistics.m_nRejected++;
+				m_Statistics.GetWriteBuffer() = m_RunningStatistics;
+				m_Statistics.Publish();
+				continue;
+			}
+			Packet.ParseBatch();
+			RecordSequence(Packet);
+
+			// NetworkTables stamps values on the same microsecond clock as the FPGA.
+			const uint64_t nChange = Notification.value->last_change();
+			Packet.m_dTimestamp = MapCaptureTime(Packet, nChange);
+			m_LatestPacket.Publish();
+
+			RecordFrame((double)(nt::Now() - nChange), m_nLastChange ? (double)(nChange - m_nLastChange) : 0.000);
+			m_nLastChange = nChange;
+		}
+	}
+}
+
+/******************************************************************************
+	Description:	Count the version 2 frames the coprocessor sent that never
+					arrived, NetworkTables only keeps the newest value so a
+					slow loop here skips frames
+	Arguments:		const CVisionPacket& Packet - Just decoded
+	Returns:		Nothing
+******************************************************************************/
+void CVisionIngest::RecordSequence(const CVisionPacket& Packet)
+{
+	if (Packet.m_nVersion != nVisionProtocolVersion) return;
+
+	// Unsigned difference handles the wrap, a coprocessor restart shows as a backwards jump and is not counted.
+	const uint32_t nGap = Packet.m_nSequence - m_nLastSequence;
+	if (m_bHasSequence && (nGap > 1) && (nGap < 0x80000000u)) m_RunningStatistics.m_nDropped += nGap - 1;
+	m_nLastSequence	= Packet.m_nSequence;
+	m_bHasSequence	= true;
+}
+
+/******************************************************************************
+	Description:	Estimate when a frame was captured on the FPGA clock.
+					Version 1 backs the arrival time off by the estimated
+					pipeline latency. Version 2 carries the capture time on
+					the coprocessor clock, and arrival minus capture is the
+					clock offset plus that frame's latency. The smallest
+					difference seen is taken as a frame with exactly the
+					estimated latency, so every other frame's extra latency
+					is measured instead of assumed. The floor creeps up to
+					follow drift between the clocks and starts over when the
+					coprocessor restarts.
+	Arguments:		const CVisionPacket& Packet - Just decoded
+					uint64_t nChange - NetworkTables arrival time (us)
+	Returns:		double - Capture time on the FPGA clock (s)
+******************************************************************************/
+double CVisionIngest::MapCaptureTime(const CVisionPacket& Packet, uint64_t nChange)
+{
+	if (Packet.m_nVersion != nVisionProtocolVersion) return ((double)nChange * 1e-6) - dVisionPipelineLatency;
+
+	const int64_t nOffset = (int64_t)nChange - (int64_t)Packet.m_nCaptureTime;
+	if (m_bHasClockOffset && m_nLastChange) m_nClockOffset += (int64_t)((double)(nChange - m_nLastChange) * dVisionClockDrift);
+	if (!m_bHasClockOffset || (nOffset < m_nClockOffset) || ((nOffset - m_nClockOffset) > (int64_t)(dVisionClockResync * 1e6))) m_nClockOffset = nOffset;
+	m_bHasClockOffset = true;
+
+	return ((double)((int64_t)Packet.m_nCaptureTime + m_nClockOffset) * 1e-6) - dVisionPipelineLatency;
+}
+
+/******************************************************************************
+	Description:	Fold one frame into the running latency and jitter numbers
+	Arguments:		double dLatency, double dInterval (zero for the first frame)
+	Returns:		Nothing
+******************************************************************************/
+void CVisionIngest::RecordFrame(double dLatency, double dInterval)
+{
+	sIngestStatistics& Running = m_RunningStatistics;
+	Running.m_nFrames++;
+	Running.m_dLatencyMean += (dLatency - Running.m_dLatencyMean) / Running.m_nFrames;
+	Running.m_dLatencyMax = fmax(Running.m_dLatencyMax, dLatency);
+
+	// Welford's method over the intervals, there is one less interval than frames.
+	if (Running.m_nFrames > 1)
+	{
+		const unsigned int nIntervals = Running.m_nFrames - 1;
+		const double dDelta = dInterval - Running.m_dIntervalMean;
+		Running.m_dIntervalMean += dDelta / nIntervals;
+		m_dIntervalM2 += dDelta * (dInterval - Running.m_dIntervalMean);
+		Running.m_dIntervalJitter = sqrt(m_dIntervalM2 / nIntervals);
+	}
+
+	m_Statistics.GetWriteBuffer() = Running;
+	m_Statistics.Publish();
+}
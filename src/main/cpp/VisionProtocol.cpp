@@ -0,0 +1,69 @@
+/******************************************************************************
+	Description:	CVisionPacketView implementation
+	Class:			CVisionPacketView
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "VisionProtocol.h"
+
+#include <array>
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+// Reflected CRC-32 lookup table for polynomial 0xEDB88320, built at compile time.
+static constexpr array<uint32_t, 256> s_anCrc32Table = []
+{
+	array<uint32_t, 256> anTable = {};
+	for (uint32_t n = 0; n < 256; n++)
+	{
+		uint32_t nCrc = n;
+		for (int nBit = 0; nBit < 8; nBit++) nCrc = (nCrc & 1) ? ((nCrc >> 1) ^ 0xEDB88320u) : (nCrc >> 1);
+		anTable[n] = nCrc;
+	}
+	return anTable;
+}();
+
+/******************************************************************************
+	Description:	CRC-32 of a buffer, matches zlib.crc32 on the coprocessor
+	Arguments:		const unsigned char* pData, size_t nLength
+	Returns:		uint32_t - CRC
+******************************************************************************/
+uint32_t VisionCrc32(const unsigned char* pData, size_t nLength)
+{
+	uint32_t nCrc = 0xFFFFFFFFu;
+	for (size_t n = 0; n < nLength; n++) nCrc = s_anCrc32Table[(nCrc ^ pData[n]) & 0xFF] ^ (nCrc >> 8);
+	return nCrc ^ 0xFFFFFFFFu;
+}
+
+/******************************************************************************
+	Description:	CVisionPacketView constructor, init variables
+	Arguments:		const unsigned char* pData - Raw packet, must outlive the view
+					size_t nLength - Bytes received
+	Derived from:	Nothing
+******************************************************************************/
+CVisionPacketView::CVisionPacketView(const unsigned char* pData, size_t nLength)
+{
+	m_pData		= pData;
+	m_nLength	= nLength;
+}
+
+/******************************************************************************
+	Description:	Check the packet is a whole version 2 packet. The length has
+					to match the detection count exactly, so every accessor
+					index below the count is inside the buffer.
+	Arguments:		None
+	Returns:		bool - True if the accessors can be used
+******************************************************************************/
+bool CVisionPacketView::Validate() const
+{
+	if (m_nLength < (size_t)(nVisionProtocolHeaderSize + nVisionProtocolTrailerSize)) return false;
+	if ((LoadBigEndian16(m_pData + nVisionHeaderMagic) != nVisionProtocolMagic) || (GetVersion() != nVisionProtocolVersion)) return false;
+	if (LoadBigEndian16(m_pData + nVisionHeaderDetectionSize) != nVisionProtocolDetectionSize) return false;
+
+	const int nCount = GetDetectionCount();
+	if ((nCount > nVisionMaxDetections) || (m_nLength != (size_t)(nVisionProtocolHeaderSize + (nCount * nVisionProtocolDetectionSize) + nVisionProtocolTrailerSize))) return false;
+
+	const size_t nBody = m_nLength - nVisionProtocolTrailerSize;
+	return VisionCrc32(m_pData, nBody) == LoadBigEndian32(m_pData + nBody);
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+	Description:	Defines the CAutoSequencer table driven autonomous routines
+	Classes:		CAutoSequencer
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef AutoSequencer_h
+#define AutoSequencer_h
+
+#include "Drive.h"
+#include "Intake.h"
+#include "Shooter.h"
+#include "Transfer.h"
+#include "Telemetry.h"
+#include "TrajectoryConstants.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const char* const pszAutoRoutineDirectory	= "autos";		// Under the deploy directory.
+const char* const pszAutoRoutineExtension	= ".auto";
+
+// Things a step does when it starts, any number per step.
+enum AutoAction : unsigned {
+	eActionDrive			= 1u << 0,		// Open loop, m_dLeftVoltage and m_dRightVoltage.
+	eActionStopDrive		= 1u << 1,
+	eActionFollow			= 1u << 2,		// Start following the path's trajectory.
+	eActionShooterOn		= 1u << 3,
+	eActionShooterIdle		= 1u << 4,
+	eActionShooterStop		= 1u << 5,
+	eActionIntakeDeploy		= 1u << 6,
+	eActionIntakeRetract	= 1u << 7,
+	eActionIntakeHold		= 1u << 8,
+	eActionIntakeOn			= 1u << 9,
+	eActionIntakeOff		= 1u << 10,
+	eActionBackOn			= 1u << 11,
+	eActionBackOff			= 1u << 12,
+	eActionVerticalOn		= 1u << 13,
+	eActionVerticalShot		= 1u << 14,
+	eActionVerticalOff		= 1u << 15
+};
+
+// What a step waits on before the next one starts.
+enum AutoCondition : int {
+	eWaitNever = 0,
+	eWaitTime,					// Seconds since the step started.
+	eWaitElapsed,				// Seconds since autonomous started.
+	eWaitVerticalBall,
+	eWaitNoVerticalBall,
+	eWaitBackBall,
+	eWaitNoBackBall,
+	eWaitNoBalls,
+	eWaitFlywheelReady,
+	eWaitShotReady,				// Flywheel at speed within m_dValue seconds, lets a ball start on its way early.
+	eWaitTrajectoryDone,
+	eWaitIntakeDown,
+	eWaitIntakeUp
+};
+
+// One compiled step, every routine's steps live back to back in one array.
+struct sAutoStep {
+	unsigned		m_nActions		= 0;
+	double			m_dLeftVoltage	= 0.000;
+	double			m_dRightVoltage	= 0.000;
+	AutoCondition	m_nCondition	= eWaitNever;
+	double			m_dValue		= 0.000;		// Seconds for eWaitTime, eWaitElapsed and eWaitShotReady.
+	double			m_dTimeout		= 0.000;		// Seconds in the step before moving on anyway, zero for none.
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CAutoSequencer class definition. Loads the autonomous
+					routines from deploy/autos, one text file per path, and
+					compiles them into a flat step array. Each step issues its
+					commands once when it starts, then every tick checks only
+					its one wait condition.
+
+					A routine file has one step per line, '#' starts a comment:
+						actions... : condition [seconds] [timeout seconds]
+					e.g.	drive -3.0 -3.0 : time 1.0
+							vertical_shot : no_vertical_ball timeout 2.0
+	Arguments:		CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer,
+					CIntake* pIntake, CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CAutoSequencer
+{
+public:
+	CAutoSequencer(CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer, CIntake* pIntake, CTelemetry* pTelemetry);
+	void Load();
+	bool Start(Paths nPath);
+	void Tick(double dElapsed);
+	void Stop();
+
+	static const char* GetRoutineName(Paths nPath);
+	static bool CompileLine(const string& strLine, sAutoStep& Step, string& strError);
+
+	// One-line methods.
+	bool	IsRunning()		{	return m_nStep >= 0;	};
+
+private:
+	void StartStep(int nStep, double dElapsed);
+	bool IsConditionMet(const sAutoStep& Step, double dElapsed);
+
+	CDrive*					m_pDrive;
+	CShooter*				m_pShooter;
+	CTransfer*				m_pTransfer;
+	CIntake*				m_pIntake;
+	CTelemetry*				m_pTelemetry;
+
+	vector<sAutoStep>		m_vSteps;
+	int						m_anFirstStep[nPathCount];
+	int						m_anStepCount[nPathCount];		// Zero when the path has no routine file.
+
+	int						m_nStep;						// Index into m_vSteps, negative when not running.
+	int						m_nLastStep;
+	double					m_dStepStart;					// Autonomous time the current step started (s).
+
+	// Telemetry handles.
+	int						m_nStepHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,70 @@
+/******************************************************************************
+	Description:	Defines the CCommandCache motor command filter
+	Classes:		CCommandCache
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef CommandCache_h
+#define CommandCache_h
+
+#include "Telemetry.h"
+
+#include <cstdint>
+#include <vector>
+#include <ctre/phoenix/motorcontrol/can/BaseMotorController.h>
+#include <rev/CANSparkMax.h>
+
+using namespace ctre::phoenix::motorcontrol;
+using namespace ctre::phoenix::motorcontrol::can;
+using namespace rev;
+using namespace std;
+
+const double	dCommandKeepAlive		= 0.100;	// Resend an unchanged command after this long (s).
+const int		nCommandSparkDutyCycle	= -1;		// Mode for CANSparkMax::Set(), below every Phoenix ControlMode.
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CCommandCache class definition. Remembers the last mode and
+					setpoint sent to each motor controller and drops repeats,
+					so a subsystem can call Start/Stop methods every loop and
+					only changes go out, plus one resend per keep-alive period.
+	Arguments:		CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CCommandCache
+{
+public:
+	CCommandCache(CTelemetry* pTelemetry);
+	int Register();
+	bool ShouldSend(int nHandle, int nMode, double dValue);
+	void InvalidateAll();
+	void Publish();
+
+	// One-line methods.
+	void	SetTime(double dTimestamp)												{	m_dTimestamp = dTimestamp;										};
+	void	Set(int nHandle, CANSparkMax* pSpark, double dValue)					{	if (ShouldSend(nHandle, nCommandSparkDutyCycle, dValue)) pSpark->Set(dValue);	};
+	void	Set(int nHandle, BaseMotorController* pTalon, ControlMode nMode, double dValue)	{	if (ShouldSend(nHandle, (int)nMode, dValue)) pTalon->Set(nMode, dValue);	};
+	void	Invalidate(int nHandle)													{	m_vCommands[nHandle].m_bValid = false;							};
+
+private:
+	// Last command sent to one controller.
+	struct sCommand {
+		bool		m_bValid		= false;
+		int			m_nMode			= 0;
+		double		m_dValue		= 0.000;
+		double		m_dSentTime		= 0.000;		// FPGA time (s).
+	};
+
+	vector<sCommand>	m_vCommands;
+	double				m_dTimestamp;				// This loop's FPGA time (s), from the sensor snapshot.
+	uint64_t			m_nSent;
+	uint64_t			m_nSuppressed;
+
+	// Telemetry handles.
+	CTelemetry*			m_pTelemetry;
+	int					m_nSentHandle;
+	int					m_nSuppressedHandle;
+	int					m_nSuppressedPercentHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
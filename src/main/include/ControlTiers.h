@@ -0,0 +1,72 @@
+/******************************************************************************
+	Description:	Defines the CControlTiers loop scheduling class
+	Classes:		CControlTiers
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef ControlTiers_h
+#define ControlTiers_h
+
+#include "Telemetry.h"
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <frc/TimedRobot.h>
+
+using namespace frc;
+using namespace std;
+
+const double	dFastTierPeriod		= 0.005;		// Fast tier period (s).
+
+// Control tiers, fast work runs from its own AddPeriodic callback and slow work from RobotPeriodic.
+enum ControlTier : int {
+	eTierFast = 0,
+	eTierSlow,
+	eTierCount
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CControlTiers class definition. Subsystems register the
+					work they want run on each tier. Both tiers are driven by
+					TimedRobot's notifier on the main thread, so tier callbacks
+					never run at the same time as each other or the mode
+					periodic functions.
+	Arguments:		TimedRobot* pRobot, CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CControlTiers
+{
+public:
+	CControlTiers(TimedRobot* pRobot, CTelemetry* pTelemetry);
+	void Register(ControlTier nTier, function<void()> Callback);
+	void RunSlowTier();
+	void PublishStatistics();
+	void ResetStatistics();
+
+private:
+	void RunTier(int nTier);
+
+	// Loop timing for one tier, all times in milliseconds.
+	struct sTierStatistics {
+		chrono::steady_clock::time_point	m_tLastStart;
+		unsigned int						m_nCount		= 0;
+		double								m_dPeriodMean	= 0.000;
+		double								m_dPeriodM2		= 0.000;	// Welford sum of squares.
+		double								m_dPeriodMax	= 0.000;
+		double								m_dRunTimeMax	= 0.000;
+	};
+
+	vector<function<void()>>	m_avCallbacks[eTierCount];
+	sTierStatistics				m_aStatistics[eTierCount];
+	CTelemetry*					m_pTelemetry;
+
+	// Telemetry handles, per tier.
+	int							m_anPeriodMeanHandle[eTierCount];
+	int							m_anJitterHandle[eTierCount];
+	int							m_anPeriodMaxHandle[eTierCount];
+	int							m_anRunTimeMaxHandle[eTierCount];
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
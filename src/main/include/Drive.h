@@ -9,6 +9,11 @@
 #include "IOMap.h"
 #include "FalconMotion.h"
 #include "TrajectoryConstants.h"
+#include "TrajectoryFollower.h"
+#include "Telemetry.h"
+#include "LatestValue.h"
+#include "ControlTiers.h"
+#include "SensorSnapshot.h"
 
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonFX.h>
 #include <frc/controller/PIDController.h>
@@ -18,12 +23,14 @@
 #include <frc/drive/DifferentialDrive.h>
 #include <frc/kinematics/DifferentialDriveOdometry.h>
 #include <frc/kinematics/DifferentialDriveWheelSpeeds.h>
-#include <frc2/command/RamseteCommand.h>
 #include <frc/trajectory/TrajectoryGenerator.h>
 #include <frc/trajectory/TrajectoryConfig.h>
 #include <frc/trajectory/Trajectory.h>
+#include <frc/trajectory/TrapezoidProfile.h>
 #include <frc/geometry/Pose2d.h>
+#ifdef __FRC_ROBORIO__
 #include <AHRS.h>
+#endif
 #include <frc/Timer.h>
 
 using namespace ctre::phoenix::motorcontrol::can;
@@ -43,6 +50,25 @@ const auto		kDefaultS								= 0.39_V;								        //	|	Drive characterizatio
 const auto		kDefaultV								= 0.0544 * 1_V * 1_s / 1_in;			        //	|	Drive characterization constants.
 const auto		kDefaultA								= 0.00583 * 1_V * 1_s * 1_s / 1_in;				//	|	Drive characterization constants.
 const DifferentialDriveKinematics	kDriveKinematics	= DifferentialDriveKinematics(inch_t(30.000));	//  |	Drive characterization constants.
+const int		nPoseHistorySize						= 256;		// Pose samples kept for vision latency compensation (~1.3s on the fast tier).
+const double	dAimMaxRate								= 270.000;	// Heading lock profile limits (deg/s, deg/s^2).
+const double	dAimMaxAcceleration						= 720.000;
+const double	dAimVelocityFeedForward					= kDefaultV.value() * 15.000 * (3.14159265 / 180.000);	// V per deg/s, kV at half the track width.
+const double	dAimProportional						= 0.150;	// V per degree behind the profile.
+const double	dAimDerivative							= 0.004;	// V per deg/s behind the profile.
+const double	dAimMaxVoltage							= 10.000;	// Turning voltage limit, leaves room for driving forward.
+const double	dAimTolerance							= 1.000;	// Settled within this many degrees of the goal...
+const double	dAimRateTolerance						= 5.000;	// ...turning slower than this (deg/s).
+const double	dAimRetarget							= 5.000;	// A goal moving further than this (deg) restarts the settle timer.
+
+// One odometry update, published to readers as a whole so pose and heading always match.
+struct sOdometrySample {
+	double		m_dTimestamp	= 0.000;			// FPGA time (s).
+	double		m_dHeading		= 0.000;			// Continuous gyro angle (degrees, clockwise positive).
+	double		m_dLeftPosition	= 0.000;			// in
+	double		m_dRightPosition= 0.000;			// in
+	Pose2d		m_Pose;
+};
 ///////////////////////////////////////////////////////////////////////////////
 
 /******************************************************************************
@@ -54,7 +80,7 @@ class CDrive
 {
 public:
 	// Declare class methods.
-	CDrive(Joystick* pDriveController);
+	CDrive(Joystick* pDriveController, CTelemetry* pTelemetry, const sSensorSnapshot* pSnapshot);
 	~CDrive();
 	void Init();
 	void Tick();
@@ -69,24 +95,87 @@ public:
 	void SetDriveSpeeds(double dLeftVoltage, double dRightVoltage);
 	bool IsTrajectoryFinished();
 	void GoForwardUntuned();				// NOTE: this is untuned and shouldn't be used in non-beta versions
-	void TurnByAngle(double dTheta);
+	void FastTick();
+	void ConfigureStatusFrames(CStatusFramePlanner* pPlanner);
+	void ReadSensors(sSensorSnapshot& Snapshot);
+	void UpdateOdometry();
+	Pose2d GetPose();
+	double GetHeadingAt(double dTimestamp);
+	Pose2d GetPoseAt(double dTimestamp);
+	void AimAtAngle(double dTheta, double dCaptureTime);
+	void AimAtHeading(double dGoal);
+	void StopAim();
 
-	DifferentialDriveOdometry*				m_pOdometry;
+	// One-line methods.
+	void	PreloadTrajectories()	{	m_pTrajectoryConstants->WarmCache();						};
+	void	StopFollowing()			{	m_bFollowing = false;										};
+	void	SetSimulatedHeading(double dHeading)	{	m_dSimulatedHeading = dHeading;				};
+	WPI_TalonFX*	GetLeftMotorPointer()	{	return m_pLeadDriveMotor1->GetMotorPointer();		};
+	WPI_TalonFX*	GetRightMotorPointer()	{	return m_pLeadDriveMotor2->GetMotorPointer();		};
+	const Trajectory*	GetArmedTrajectory()	{	return m_pTrajectoryFollower->IsArmed() ? m_pTrajectory.get() : nullptr;	};
+	CTrajectoryConstants*	GetTrajectoryConstants()	{	return m_pTrajectoryConstants;					};
+	bool	IsAiming()				{	return m_bAiming;											};
+	bool	IsAimSettled()			{	return m_bAiming && m_bAimSettled;							};
+	double	GetAimSettleTime()		{	return m_dAimSettleTime;									};
 
 private:
+	void UpdateTelemetry();
+	double GetGyroAngle();
+	void ZeroGyro();
+	void UpdateAim(double dHeading);
+	double GetTurnRate();
+	bool GetHistoryAt(double dTimestamp, int& nOlder, int& nNewer, double& dRatio);
+
 	// Declare class objects and variables.
 	bool									m_bJoystickControl;
+	bool									m_bFollowing;		// Fast tier drives the follower while set.
 	CFalconMotion*							m_pLeadDriveMotor1;
 	WPI_TalonFX*							m_pFollowMotor1;
 	CFalconMotion*							m_pLeadDriveMotor2;
 	WPI_TalonFX*							m_pFollowMotor2;
+#ifdef __FRC_ROBORIO__
 	AHRS*									m_pGyro;
+#endif
+	double									m_dSimulatedHeading;		// Set by CRobotSim, the navX has no desktop build.
+	double									m_dSimulatedHeadingZero;
 	Joystick*								m_pDriveController;
+	CTelemetry*								m_pTelemetry;
+	const sSensorSnapshot*					m_pSnapshot;
 	DifferentialDrive*						m_pRobotDrive;
 	Timer*									m_pTimer;
 	CTrajectoryConstants*					m_pTrajectoryConstants;
-	RamseteCommand*							m_pRamseteCommand;
-	Trajectory								m_Trajectory;
+	CTrajectoryFollower*					m_pTrajectoryFollower;
+	shared_ptr<const Trajectory>			m_pTrajectory;		// Shared with the trajectory cache, never copied.
+
+	DifferentialDriveOdometry*				m_pOdometry;
+	CLatestValue<sOdometrySample>			m_LatestOdometry;
+
+	// Time ordered ring of recent odometry samples, m_nPoseHistoryHead is the next slot written.
+	sOdometrySample							m_aPoseHistory[nPoseHistorySize];
+	int										m_nPoseHistoryHead;
+	int										m_nPoseHistoryCount;
+
+	// Heading lock, a profiled turn to an absolute gyro heading run on the fast tier.
+	bool									m_bAiming;
+	bool									m_bAimSettled;
+	double									m_dAimGoal;			// Continuous gyro angle (degrees).
+	double									m_dAimForward;		// Driver's forward voltage while locked.
+	double									m_dAimStartTime;	// FPGA time the current target was acquired (s).
+	double									m_dAimSettleTime;	// Acquire to settled for the last target (s), negative if none yet.
+	TrapezoidProfile<units::degrees>::State	m_AimSetpoint;
+
+	// Telemetry handles.
+	int										m_nLeftPowerHandle;
+	int										m_nRightPowerHandle;
+	int										m_nLeftVelocityHandle;
+	int										m_nRightVelocityHandle;
+	int										m_nLeftPositionHandle;
+	int										m_nRightPositionHandle;
+	int										m_nPoseXHandle;
+	int										m_nPoseYHandle;
+	int										m_nPoseHeadingHandle;
+	int										m_nAimErrorHandle;
+	int										m_nAimSettleHandle;
 };
 ///////////////////////////////////////////////////////////////////////////////
 #endif
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <frc/smartdashboard/SmartDashboard.h>
 #include <frc/Timer.h>
 #include "IOMap.h"
+#include "StatusFramePlanner.h"
 
 using namespace ctre::phoenix::motorcontrol::can;
 using namespace frc;
@@ -84,6 +85,7 @@ public:
 
     // One-line Methods.
     WPI_TalonFX*	GetMotorPointer()					{ return m_pMotor;														};
+    int		AddToStatusFramePlan(CStatusFramePlanner* pPlanner)	{ return pPlanner->AddTalon(m_pMotor, eCanTalonFX);				};
     bool	IsReady()									{ return m_bReady;														};
     bool	IsHomingComplete()							{ return m_bHomingComplete;												};
     void	SetMaxHomingTime(double dMaxHomingTime)		{ m_dMaxHomingTime = dMaxHomingTime;									};
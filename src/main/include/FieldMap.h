@@ -0,0 +1,79 @@
+/******************************************************************************
+	Description:	Defines the CFieldMap field relative cargo map
+	Classes:		CFieldMap
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef FieldMap_h
+#define FieldMap_h
+
+#include "Vision.h"
+#include "Telemetry.h"
+
+#include <array>
+#include <cmath>
+#include <frc/geometry/Pose2d.h>
+
+using namespace frc;
+using namespace std;
+
+// The grid is centred on the odometry origin, so it reaches a full field away in every direction.
+const double dFieldMapCellSize			= 0.500;	// m
+const int nFieldMapColumns				= 66;		// 33m along x.
+const int nFieldMapRows					= 34;		// 17m along y.
+const double dFieldMapDecayTime			= 3.000;	// s for a sighting's evidence to fall to 1/e.
+const double dFieldMapConfirmed			= 1.500;	// Evidence needed before a cell is returned as cargo.
+const double dFieldMapMinRange			= 0.500;	// m, cameras can't see cargo closer than this...
+const double dFieldMapMaxRange			= 4.000;	// ...and aren't trusted to miss it further than this.
+const double dFieldMapMissScale			= 0.500;	// Evidence kept by a cell a camera looked at and didn't see cargo in.
+const double dFieldMapForget			= 0.050;	// Cells weakened below this are emptied.
+const double dFieldMapFootprint			= 0.500;	// m, cargo this close to the robot's centre has been run over or picked up.
+const double dCameraHalfFieldOfView		= 69.000 / 2.000;	// degrees, matches dAnglePerPixel.
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CFieldMap class definition. Projects cargo detections from
+					both cameras through the odometry pose at capture time into
+					a fixed grid, one layer per alliance colour. Evidence decays
+					with time, builds up with repeated sightings and drops when
+					a camera looks at a cell and sees nothing, so the map still
+					knows where cargo is after it leaves the cameras' view.
+	Arguments:		CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CFieldMap
+{
+public:
+	CFieldMap(CTelemetry* pTelemetry);
+	void Update(const CVisionPacket* pPacket, const Pose2d& Pose);
+	void ClearFootprint(const Pose2d& Pose, double dTime);
+	void Reset();
+	bool FindNearest(DetectionClass kClass, const Translation2d& From, double dTime, Translation2d& Cargo);
+	void Publish(double dTime);
+
+private:
+	// One grid cell, evidence is as of m_dTime and decays from there.
+	struct sCell {
+		double		m_dEvidence		= 0.000;
+		double		m_dTime			= 0.000;		// FPGA time (s).
+		double		m_dX			= 0.000;		// Evidence weighted cargo position in the cell (m).
+		double		m_dY			= 0.000;
+	};
+
+	static int GetLayer(DetectionClass kClass);
+	static int GetCell(double dX, double dY);
+	static int GetColumn(double dX)		{	return (int)floor((dX / dFieldMapCellSize) + (nFieldMapColumns / 2));	};
+	static int GetRow(double dY)		{	return (int)floor((dY / dFieldMapCellSize) + (nFieldMapRows / 2));		};
+	static double GetEvidence(const sCell& Cell, double dTime);
+
+	array<sCell, nFieldMapColumns * nFieldMapRows>	m_aLayers[2];		// Red cargo, then blue.
+	array<bool, nFieldMapColumns * nFieldMapRows>	m_abSeen;			// Cells hit by the frame being added.
+	double											m_dLastFrame;		// Capture time of the last frame used (s).
+
+	// Telemetry handles.
+	CTelemetry*										m_pTelemetry;
+	int												m_nRedHandle;
+	int												m_nBlueHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,108 @@
+/******************************************************************************
+	Description:	Defines the CFlightRecorder match logging class
+	Classes:		CFlightRecorder
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef FlightRecorder_h
+#define FlightRecorder_h
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+const unsigned int	nFlightRecorderRingSize		= 1024;					// Records buffered in memory, must be a power of two.
+const unsigned int	nFlightRecorderFileRecords	= 50 * 60 * 10;			// Records per log file, 10 minutes at 50Hz.
+const int			nFlightRecorderMaxFiles		= 40;					// Oldest files are deleted past this, about 48MB.
+const uint32_t		nFlightRecorderMagic		= 0x43455246;			// "FREC" little endian.
+const uint32_t		nFlightRecorderVersion		= 1;
+const char* const	pszFlightRecorderDirectory	= "/home/lvuser/logs";		// roboRIO default, FLIGHT_RECORDER_DIR overrides it.
+
+// Record flag bits.
+enum FlightRecordFlags : uint8_t {
+	eVerticalBall	= 0x01,
+	eBackBall		= 0x02,
+	eIntakeDown		= 0x04,
+	eIntakeUp		= 0x08
+};
+
+// Robot mode for the record.
+enum FlightRecordMode : uint8_t {
+	eModeDisabled = 0,
+	eModeAutonomous,
+	eModeTeleop,
+	eModeTest
+};
+
+// One record per robot loop. Fixed layout, tools/flight_reader.py must match.
+struct sFlightRecord {
+	double		m_dTimestamp;			// FPGA time (s).
+	float		m_fLeftVoltage;
+	float		m_fRightVoltage;
+	float		m_fLeftVelocity;		// m/s
+	float		m_fRightVelocity;		// m/s
+	float		m_fLeftPosition;		// in
+	float		m_fRightPosition;		// in
+	float		m_fFlywheelVelocity;	// Sensor units per 100ms.
+	uint8_t		m_nMode;
+	uint8_t		m_nAutoState;
+	uint8_t		m_nTeleopState;
+	uint8_t		m_nFlags;
+};
+static_assert(sizeof(sFlightRecord) == 40, "sFlightRecord layout is part of the log file format");
+
+// Log file header, followed by nCapacity records.
+struct sFlightRecorderHeader {
+	uint32_t	m_nMagic;
+	uint32_t	m_nVersion;
+	uint32_t	m_nRecordSize;
+	uint32_t	m_nCapacity;
+	uint32_t	m_nCount;				// Records written so far.
+	uint32_t	m_nDropped;				// Records lost to a full ring or a full file.
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CFlightRecorder class definition. Record() copies a snapshot
+					into a lock-free ring on the robot thread; a low priority
+					thread drains the ring into a memory mapped log file.
+					Rotate() starts a new file at the start of each enabled
+					period, so time spent disabled in the queue never pushes
+					a match out of its file.
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CFlightRecorder
+{
+public:
+	CFlightRecorder();
+	~CFlightRecorder();
+	bool Start(const std::string& strDirectory);
+	void Stop();
+	void Rotate();
+	bool Record(const sFlightRecord& Record);
+
+private:
+	bool OpenLogFile();
+	void PruneLogFiles(int nNewest);
+	void CloseLogFile();
+	void WriterThread();
+	void Drain();
+
+	sFlightRecord				m_aRing[nFlightRecorderRingSize];
+	std::atomic<unsigned int>	m_nHead;			// Next slot written by Record().
+	std::atomic<unsigned int>	m_nTail;			// Next slot drained by the writer.
+	std::atomic<unsigned int>	m_nDropped;
+	std::atomic<bool>			m_bRunning;
+	std::atomic<bool>			m_bRotate;			// Set by Rotate(), the writer thread swaps files.
+	std::thread					m_Thread;
+	std::string					m_strDirectory;
+
+	int							m_nFile;
+	sFlightRecorderHeader*		m_pHeader;
+	sFlightRecord*				m_pRecords;
+	size_t						m_nMappedSize;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
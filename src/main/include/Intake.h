@@ -6,6 +6,10 @@
 #ifndef Intake_h
 #define Intake_h
 
+#include "StatusFramePlanner.h"
+#include "SensorSnapshot.h"
+#include "CommandCache.h"
+
 #include <frc/Compressor.h>
 #include <frc/DigitalInput.h>
 #include <rev/CANSparkMax.h>
@@ -25,7 +29,7 @@ class CIntake
 {
 public:
 	// Public methods
-    CIntake(int nIntakeMotor1, int nIntakeDownLimitSwitch, int nIntakeUpLimitSwitch, int nDeployController, bool IntakePosition);
+    CIntake(const sIntakeSensors* pSensors, CCommandCache* pCommandCache, int nIntakeMotor1, int nIntakeDownLimitSwitch, int nIntakeUpLimitSwitch, int nDeployController, bool IntakePosition);
     ~CIntake();
 	void Init();
 	bool IsGoalPressed();
@@ -35,6 +39,12 @@ public:
 	void MoveIntake(bool bUp);
 	void StartIntake(bool bSafe = true);
 	bool GetLimitSwitchState(bool bUp);
+	void ConfigureStatusFrames(CStatusFramePlanner* pPlanner);
+	void ReadSensors(sIntakeSensors& Sensors);
+
+	// One-line methods.
+	double	GetDeployOutput()		{	return m_pIntakeDeployMotorController1->Get();	};
+	double	GetIntakeOutput()		{	return m_pIntakeMotor1->Get();					};
 
 	// Public members
 	bool m_bGoal;		// If true, up; else, down
@@ -46,6 +56,10 @@ private:
 	DigitalInput*	m_pLimitSwitchUp;
 	CANSparkMax*	m_pIntakeMotor1;
 	WPI_TalonSRX*	m_pIntakeDeployMotorController1;
+	const sIntakeSensors*	m_pSensors;		// This loop's limit switch states.
+	CCommandCache*	m_pCommandCache;
+	int				m_nIntakeCommand;
+	int				m_nDeployCommand;
 
 	bool m_bIntakeUp;
 	bool m_bIntakeDown;
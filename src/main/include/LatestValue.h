@@ -0,0 +1,52 @@
+/******************************************************************************
+	Description:	Defines the CLatestValue single producer/consumer handoff
+	Classes:		CLatestValue
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef LatestValue_h
+#define LatestValue_h
+
+#include <atomic>
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CLatestValue class definition. A lock-free triple buffer:
+					one thread fills the write buffer and publishes it, another
+					thread picks up the newest published value. Neither side
+					ever waits and older unread values are simply dropped.
+	Arguments:		T - Value type, must be default constructible
+	Derived From:	Nothing
+******************************************************************************/
+template <typename T>
+class CLatestValue
+{
+public:
+	// Producer side.
+	T& GetWriteBuffer()							{	return m_aBuffers[m_nWriteIndex];		};
+	void Publish()
+	{
+		// Hand the filled buffer over and take back whichever one was shared.
+		m_nWriteIndex = m_nShared.exchange(m_nWriteIndex | nDirtyBit, std::memory_order_acq_rel) & nIndexMask;
+	}
+
+	// Consumer side. Returns true if a newer value was picked up.
+	bool Update()
+	{
+		if (!(m_nShared.load(std::memory_order_acquire) & nDirtyBit)) return false;
+		m_nReadIndex = m_nShared.exchange(m_nReadIndex, std::memory_order_acq_rel) & nIndexMask;
+		return true;
+	}
+	const T& GetReadBuffer() const				{	return m_aBuffers[m_nReadIndex];		};
+
+private:
+	static const int nIndexMask	= 0x3;
+	static const int nDirtyBit	= 0x4;
+
+	T					m_aBuffers[3];
+	std::atomic<int>	m_nShared		{1};
+	int					m_nWriteIndex	= 0;
+	int					m_nReadIndex	= 2;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
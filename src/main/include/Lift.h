@@ -7,6 +7,8 @@
 #define Lift_h
 
 #include "IOMap.h"
+#include "StatusFramePlanner.h"
+#include "CommandCache.h"
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonFX.h>
 #include <frc/Solenoid.h>
 
@@ -23,16 +25,19 @@ class CLift
 {
 public:
 	// Declare class methods.
-	CLift();
+	CLift(CCommandCache* pCommandCache);
 	~CLift();
 	void Tick();
 	void Init();
 	void MoveArms(double dJoystickPosition);
+	void ConfigureStatusFrames(CStatusFramePlanner* pPlanner);
 
 private:
 	// Declare class objects and variables.
 	WPI_TalonFX*		m_pLiftMotor1;
 	WPI_TalonFX*		m_pLiftMotor2;
+	CCommandCache*		m_pCommandCache;
+	int					m_nLiftCommand;
 };
 ///////////////////////////////////////////////////////////////////////////////
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+/******************************************************************************
+	Description:	Defines the CLoopProfiler loop timing instrumentation
+	Classes:		CLoopProfiler, CScopedTimer
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef LoopProfiler_h
+#define LoopProfiler_h
+
+#include <chrono>
+#include <cstdint>
+
+// Instrumented sites, add new ones before eProfileSiteCount and name them in LoopProfiler.cpp.
+enum ProfileSite : int {
+	eProfileShooterTick = 0,
+	eProfileTransferUpdate,
+	eProfileLiftTick,
+	eProfileDriveTick,
+	eProfileTeleopVision,
+	eProfileSelfTest,			// Only used to measure the profiler's own overhead.
+	eProfileSiteCount
+};
+
+// Log-linear histogram, exact below 16ns then 16 buckets per power of two (~6% resolution).
+const int nProfileSubBucketBits		= 4;
+const int nProfileBucketCount		= (32 - nProfileSubBucketBits + 1) << nProfileSubBucketBits;
+
+// Build with ENABLE_LOOP_PROFILER (see build.gradle) to turn the timers on, otherwise they compile to nothing.
+#ifdef ENABLE_LOOP_PROFILER
+#define PROFILE_CONCAT_INNER(a, b)	a##b
+#define PROFILE_CONCAT(a, b)		PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(nSite)		CScopedTimer PROFILE_CONCAT(ScopedTimer, __LINE__)(nSite)
+#else
+#define PROFILE_SCOPE(nSite)
+#endif
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CLoopProfiler class definition. Keeps one histogram of
+					execution times per instrumented site.
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CLoopProfiler
+{
+public:
+	static void Record(int nSite, uint32_t nNanoseconds);
+	static double GetPercentile(int nSite, double dPercentile);
+	static double GetMax(int nSite);
+	static double MeasureOverhead(int nIterations);
+	static void Publish();
+	static void Reset(int nSite);
+
+private:
+	static int BucketIndex(uint32_t nNanoseconds);
+	static uint32_t BucketValue(int nIndex);
+
+	static uint32_t		m_aBuckets[eProfileSiteCount][nProfileBucketCount];
+	static uint32_t		m_aCounts[eProfileSiteCount];
+	static uint32_t		m_aMax[eProfileSiteCount];
+};
+
+/******************************************************************************
+	Description:	CScopedTimer class definition. Times its own lifetime into
+					a CLoopProfiler site, use it through PROFILE_SCOPE().
+	Arguments:		int nSite
+	Derived From:	Nothing
+******************************************************************************/
+class CScopedTimer
+{
+public:
+	CScopedTimer(int nSite) : m_nSite(nSite), m_tStart(std::chrono::steady_clock::now()) {}
+	~CScopedTimer()
+	{
+		const auto tElapsed = std::chrono::steady_clock::now() - m_tStart;
+		CLoopProfiler::Record(m_nSite, (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(tElapsed).count());
+	}
+
+private:
+	int										m_nSite;
+	std::chrono::steady_clock::time_point	m_tStart;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -10,9 +10,21 @@
 #include "Drive.h"
 #include "Intake.h"
 #include "Vision.h"
+#include "VisionIngest.h"
+#include "TargetTracker.h"
+#include "FieldMap.h"
 #include "Shooter.h"
 #include "Lift.h"
 #include "Transfer.h"
+#include "Telemetry.h"
+#include "FlightRecorder.h"
+#include "ControlTiers.h"
+#include "StatusFramePlanner.h"
+#include "SensorSnapshot.h"
+#include "RobotSim.h"
+#include "SimScenario.h"
+#include "AutoSequencer.h"
+#include "CommandCache.h"
 
 #include <string>
 #include <frc/TimedRobot.h>
@@ -21,6 +33,11 @@
 ///////////////////////////////////////////////////////////////////////////////
 using namespace frc;
 
+// YOLO Terminator cargo hunting.
+const double dHuntHeadingTolerance	= 15.000;	// Degrees off the cargo before reversing stops to turn again.
+const double dHuntReverseVoltage	= 4.000;
+const double dHuntSearchVoltage		= 2.000;	// Turning in place while the map has no cargo.
+
 class CRobotMain : public TimedRobot {
 public:
 	CRobotMain();
@@ -35,8 +52,13 @@ public:
 	void DisabledPeriodic() override;
 	void TestInit() override;
 	void TestPeriodic() override;
+	void SimulationInit() override;
+	void SimulationPeriodic() override;
 
 private:
+	void ReadSensors();
+	void RecordFlight();
+
 	enum TeleopStates {
 		eTeleopStopped = 0,
 		eTeleopIdle,
@@ -56,8 +78,26 @@ private:
 	CIntake*							m_pBackIntake;
 	CShooter*							m_pShooter;
 	CLift*								m_pLift;
-	CVisionPacket*						m_pPrevVisionPacket;
+	CVisionIngest*						m_pVisionIngest;
+	CTargetTracker*						m_pTargetTracker;
+	CFieldMap*							m_pFieldMap;
 	CTransfer*							m_pTransfer;
+	CTelemetry*							m_pTelemetry;
+	CFlightRecorder*					m_pFlightRecorder;
+	CControlTiers*						m_pControlTiers;
+	CStatusFramePlanner*				m_pStatusFramePlanner;
+	CAutoSequencer*						m_pAutoSequencer;
+	CCommandCache*						m_pCommandCache;
+	CRobotSim*							m_pRobotSim;		// Only created in simulation.
+	CSimScenario*						m_pSimScenario;		// Only created for headless autonomous runs.
+	sSensorSnapshot						m_Snapshot;			// Written only by ReadSensors().
+
+	// Telemetry handles.
+	int		m_nVerticalInfraredHandle;
+	int		m_nBackInfraredHandle;
+	int		m_nBackDownLimitHandle;
+	int		m_nBackUpLimitHandle;
+	int		m_nRecordTimeHandle;
 
 	double	m_dStartTime;							// A double representing start time
 	Paths	m_nAutoState;							// Current Auto state
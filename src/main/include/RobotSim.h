@@ -0,0 +1,136 @@
+/******************************************************************************
+	Description:	Defines the CRobotSim desktop physics models
+	Classes:		CRobotSim
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef RobotSim_h
+#define RobotSim_h
+
+#include "ControlTiers.h"
+#include "Drive.h"
+#include "Intake.h"
+#include "Shooter.h"
+#include "Transfer.h"
+#include "Telemetry.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <frc/geometry/Pose2d.h>
+#include <frc/simulation/DIOSim.h>
+#include <frc/simulation/DifferentialDrivetrainSim.h>
+#include <frc/simulation/FlywheelSim.h>
+
+using namespace frc;
+using namespace std;
+using namespace units;
+
+// Drive model, Falcon gearing and wheel from FalconMotion.h, track width from kDriveKinematics.
+const double	dSimDriveGearing				= 84.000 / 8.000;
+const double	dSimDriveWheelRadius			= 6.32640898790284 / 2.000;	// in
+const double	dSimDriveTrackWidth				= 30.000;					// in
+const double	dSimDriveMass					= 54.000;					// kg, robot with bumpers and battery.
+const double	dSimDriveInertia				= 4.500;					// kg m^2 about the vertical axis.
+// Flywheel model, two Falcons direct driven (see m_dPeakSensorVelocity in Shooter.h).
+const double	dSimFlywheelInertia				= 0.0025;					// kg m^2
+const double	dSimShotSpeedRetained			= 0.850;					// Fraction of flywheel speed left after a ball goes through.
+const double	dSimShotVelocityTolerance		= 0.100;					// Fraction of the expected velocity a shot still scores within.
+// Ball path, times are at full motor output.
+const double	dSimIntakeDeployTime			= 0.350;					// s, fully up to fully down.
+const double	dSimPickupTime					= 0.400;					// s of intake down, running and driving per ball picked up.
+const double	dSimPickupMinSpeed				= 0.200;					// m/s
+const double	dSimBackTransferTime			= 0.300;					// s, back sensor to the bottom of the vertical transfer.
+const double	dSimVerticalTravelTime			= 0.250;					// s, bottom of the vertical transfer into the flywheel.
+const double	dSimVerticalSensorPosition		= 0.500;					// Fraction of the vertical travel where the top infrared sits.
+// Accelerated stepping.
+const double	dSimStepPeriod					= dFastTierPeriod;			// s, each step runs one model step and one fast tier tick.
+
+// Conditions varied between runs, the defaults are a nominal robot.
+struct sSimPerturbation {
+	unsigned	m_nSeed					= 0;
+	double		m_dBatteryVoltage		= 12.000;	// V, open circuit.
+	double		m_dBatteryResistance	= 0.020;	// Ohm
+	double		m_dFrictionScale		= 1.000;	// Multiplier on the drive's characterized kS.
+	double		m_dEncoderNoise			= 0.000;	// in, standard deviation per reading.
+	double		m_dGyroNoise			= 0.000;	// degrees, standard deviation per reading.
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CRobotSim class definition. Physics for the drive, flywheel
+					and ball path, stepped every fast tier period with a
+					fixed step so a run only depends on its inputs. Reads
+					what the subsystems command through the Phoenix and REV
+					sim interfaces and writes back encoders, gyro and the
+					infrared and limit switch DIOs.
+	Arguments:		CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer,
+					CIntake* pIntake, CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CRobotSim
+{
+public:
+	CRobotSim(CDrive* pDrive, CShooter* pShooter, CTransfer* pTransfer, CIntake* pIntake, CTelemetry* pTelemetry);
+	~CRobotSim();
+	void Reset(const Pose2d& StartPose, int nFieldBalls);
+	void SetPerturbation(const sSimPerturbation& Perturbation);
+	void Tick(double dPeriod);
+	void StartAccelerated();
+	void StopAccelerated();
+
+	// One-line methods.
+	Pose2d	GetPose()				{	return m_pDriveSim->GetPose();	};
+	int		GetBallsFired()			{	return m_nBallsFired;			};
+	int		GetBallsScored()		{	return m_nBallsScored;			};
+	double	GetFirstShotTime()		{	return m_dFirstShotTime;		};
+	double	GetElapsedTime()		{	return m_dElapsedTime;			};
+
+private:
+	void UpdateDrive(double dPeriod);
+	void UpdateFlywheel(double dPeriod);
+	void UpdateBalls(double dPeriod);
+	void UpdateSensors();
+	static double ApplyFriction(double dVoltage, double dVelocity, double dFriction);
+
+	CDrive*							m_pDrive;
+	CShooter*						m_pShooter;
+	CTransfer*						m_pTransfer;
+	CIntake*						m_pIntake;
+	CTelemetry*						m_pTelemetry;
+
+	sim::DifferentialDrivetrainSim*	m_pDriveSim;
+	sim::FlywheelSim*				m_pFlywheelSim;
+	sim::DIOSim*					m_pBackInfraredSim;
+	sim::DIOSim*					m_pTopInfraredSim;
+	sim::DIOSim*					m_pIntakeDownSim;
+	sim::DIOSim*					m_pIntakeUpSim;
+
+	// Ball path state, positions are fractions of each stage's travel.
+	double							m_dIntakePosition;		// 0 up, 1 down.
+	double							m_dPickupProgress;
+	bool							m_bBackBall;
+	double							m_dBackPosition;
+	bool							m_bVerticalBall;
+	double							m_dVerticalPosition;
+	int								m_nFieldBalls;			// Balls left where the intake can reach them.
+	int								m_nBallsFired;
+	int								m_nBallsScored;
+	double							m_dElapsedTime;			// s since Reset().
+	double							m_dFirstShotTime;		// s since Reset(), negative until a ball is fired.
+
+	sSimPerturbation				m_Perturbation;
+	mt19937							m_Random;
+	normal_distribution<double>		m_Noise;				// Unit normal, scaled per sensor.
+
+	atomic<bool>					m_bAccelerated;
+	thread							m_StepThread;
+
+	// Telemetry handles.
+	int								m_nPoseXHandle;
+	int								m_nPoseYHandle;
+	int								m_nBallsScoredHandle;
+	int								m_nBatteryHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,42 @@
+/******************************************************************************
+	Description:	Defines the per-loop sensor snapshot
+	Classes:		None
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef SensorSnapshot_h
+#define SensorSnapshot_h
+///////////////////////////////////////////////////////////////////////////////
+
+// Limit switches on one intake, true when pressed.
+struct sIntakeSensors {
+	bool		m_bDownPressed		= false;
+	bool		m_bUpPressed		= false;
+};
+
+// Every sensor the robot loop reads, filled once at the top of each loop by
+// CRobotMain::ReadSensors(); subsystems only ever see it through a const pointer.
+struct sSensorSnapshot {
+	double			m_dTimestamp			= 0.000;	// FPGA time (s).
+
+	// Drive, motor 1 is the left side.
+	double			m_dLeftVoltage			= 0.000;	// V
+	double			m_dRightVoltage			= 0.000;	// V
+	double			m_dLeftVelocity			= 0.000;	// m/s
+	double			m_dRightVelocity		= 0.000;	// m/s
+	double			m_dLeftPosition			= 0.000;	// in, from the fast tier's last odometry update.
+	double			m_dRightPosition		= 0.000;	// in, from the fast tier's last odometry update.
+	double			m_dHeading				= 0.000;	// Continuous gyro angle (degrees), from the same update.
+
+	// Shooter.
+	double			m_dFlywheelVelocity		= 0.000;	// Sensor units per 100ms, from the fast tier.
+
+	// Intake.
+	sIntakeSensors	m_BackIntake;
+
+	// Transfer, raw infrared before debouncing, true when the beam is broken.
+	bool			m_bVerticalInfrared		= false;
+	bool			m_bBackInfrared			= false;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -8,9 +8,15 @@
 
 #include "IOMap.h"
 #include "FalconMotion.h"
+#include "Telemetry.h"
+#include "StatusFramePlanner.h"
+#include "CommandCache.h"
+#include "ControlTiers.h"
+#include "ShotTable.h"
 #include <rev/CANSparkMax.h>
 #include <ctre/phoenix/motorcontrol/can/WPI_TalonFX.h>
 #include <frc/Joystick.h>
+#include <frc/filter/LinearFilter.h>
 #include <frc/smartdashboard/SmartDashboard.h>
 
 using namespace frc;
@@ -18,6 +24,14 @@ using namespace rev;
 using namespace units;
 using namespace ctre::phoenix::motorcontrol;
 
+// Readiness estimator, velocities are sensor units per 100ms.
+const double dShooterReadyTolerance         = 100.000;      // Either side of the shot velocity.
+const double dShooterFilterTimeConstant     = 0.020;        // s, velocity low pass.
+const double dShooterShotDip                = 250.000;      // Drop below the shot velocity that means a ball went through.
+const double dShooterRecoveryGain           = 0.250;        // Weight of the newest recovery time in the running mean.
+const double dShooterDefaultRecovery        = 0.500;        // s, until a recovery has been measured.
+const double dShooterSetpointDeadband       = 50.000;       // Smaller shot table changes aren't sent, so depth noise doesn't churn the setpoint.
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /******************************************************************************
@@ -29,18 +43,30 @@ class CShooter
 {
 public:
     // Declare class methods.
-    CShooter();
+    CShooter(CTelemetry* pTelemetry, CCommandCache* pCommandCache);
     ~CShooter();
     void Init();
+    void FastTick();
+    void ConfigureStatusFrames(CStatusFramePlanner* pPlanner);
     void Tick();
     void StartFlywheelShot();
     void IdleStop();
 	void Stop();
     void SetSafety(bool bSafety);
     void AdjustVelocity(double dVelocityPercent);
+    void LoadShotTable();
+    void SetHubDistance(double dDistance);
+    void ClearHubDistance();
+
+    // One-line methods.
+    WPI_TalonFX*    GetFlywheelMotorPointer()   {   return m_pFlywheelMotor1;           };
+    double          GetExpectedShotVelocity()   {   return m_dExpectedShotVelocity;     };
+    double          GetReadyIn()                {   return m_dReadyIn;                  };
+    int             GetShotCount()              {   return m_nShotCount;                };
 
     bool m_bShooterOn;
     bool m_bShooterFullSpeed;
+    double m_dFlywheelVelocity;         // Last velocity read in FastTick(), sensor units per 100ms.
 
     double m_dFlywheelMotorSpeed = 0.400;
     double m_dIdleMotorSpeed = 0.375;
@@ -48,6 +74,37 @@ private:
     // Declare class objects and variables.
     WPI_TalonFX*      m_pFlywheelMotor1;
     WPI_TalonFX*      m_pFlywheelMotor2;
+    CTelemetry*       m_pTelemetry;
+    CCommandCache*    m_pCommandCache;
+    int               m_nFlywheelCommand;
+    int               m_nVelocityHandle;
+    int               m_nReadyInHandle;
+    int               m_nLastRecoveryHandle;
+    int               m_nMeanRecoveryHandle;
+    int               m_nShotCountHandle;
+    int               m_nHubDistanceHandle;
+    int               m_nShotVelocityHandle;
+    int               m_nExpectedShotHandle;
+    int               m_nExpectedIdleHandle;
+
+    // Distance based shot speed, refreshed from the hub's track.
+    void UpdateShotVelocity();
+    double GetShotSpeed()   {   return (m_pShotTable->IsLoaded() && (m_dHubDistance >= 0.000)) ? (m_pShotTable->Lookup(m_dHubDistance) + m_dShotTrim) : m_dFlywheelMotorSpeed;  };
+    CShotTable*       m_pShotTable;
+    double            m_dHubDistance;       // mm, negative while the hub isn't tracked.
+    double            m_dShotTrim;          // D-pad adjustments, added on top of the table's speed.
+
+    // Readiness estimator, updated every fast tier tick.
+    LinearFilter<double> m_VelocityFilter;
+    double            m_dFilteredVelocity;
+    double            m_dAcceleration;      // Filtered, sensor units per 100ms per second.
+    bool              m_bShotArmed;         // At speed since the last shot, so the next dip is a ball.
+    bool              m_bRecovering;
+    double            m_dShotTime;          // FPGA time of the last shot (s).
+    double            m_dLastRecovery;      // s
+    double            m_dMeanRecovery;      // s
+    double            m_dReadyIn;           // s until at speed, zero when ready and negative when unknown.
+    int               m_nShotCount;
 
     bool m_bSafety;
     bool m_bIdle;
@@ -0,0 +1,51 @@
+/******************************************************************************
+	Description:	Defines the CShotTable hub distance to flywheel speed table
+	Classes:		CShotTable
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef ShotTable_h
+#define ShotTable_h
+
+#include <vector>
+
+using namespace std;
+
+const char* const pszShotTableFile	= "shooter/shot_table.csv";		// Under the deploy directory.
+const double dShotTableStep			= 25.000;		// Hub distance between resampled entries (mm).
+const int nShotTableMaxEntries		= 2048;			// Resampled entries, bounds the distance span to about 50m.
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CShotTable class definition. Loads measured distance and
+					speed pairs from the deploy directory and resamples them
+					onto an even distance grid, so a lookup is one multiply,
+					one index and one interpolation between neighbours. The
+					last grid entry usually lies past the last point, it is
+					extrapolated along the last segment so every step stays
+					dShotTableStep wide.
+
+					Each line of the file is a hub distance in millimetres, as
+					sent by the coprocessor, and a flywheel speed as a fraction
+					of peak, '#' starts a comment:
+						5180, 0.400
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CShotTable
+{
+public:
+	CShotTable();
+	bool Load();
+	double Lookup(double dDistance) const;
+
+	// One-line methods.
+	bool	IsLoaded() const		{	return !m_vSpeeds.empty();	};
+
+private:
+	double				m_dMinDistance;			// Distance of m_vSpeeds[0] (mm).
+	double				m_dMaxDistance;			// Distance of the last measured point (mm), lookups clamp to it.
+	vector<double>		m_vSpeeds;				// Speed every dShotTableStep from m_dMinDistance.
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,75 @@
+/******************************************************************************
+	Description:	Defines the CSimScenario headless autonomous run
+	Classes:		CSimScenario
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef SimScenario_h
+#define SimScenario_h
+
+#include "RobotSim.h"
+#include "Drive.h"
+#include "TargetTracker.h"
+#include "TrajectoryConstants.h"
+#include "Vision.h"
+
+#include <string>
+
+using namespace frc;
+using namespace std;
+
+// One autonomous run, read from SIM_* environment variables by tools/sim_batch.py.
+struct sSimScenario {
+	Paths				m_nPath				= eAutoIdle;
+	sSimPerturbation	m_Perturbation;
+	int					m_nFieldBalls		= 1;		// Balls the intake can reach.
+	double				m_dDuration			= 15.000;	// s of autonomous.
+	string				m_strResultFile;				// Empty prints the result to stdout.
+	double				m_dAimAngle			= 0.000;	// Hub bearing for a heading lock step (degrees), zero for none. Must be in the camera's view.
+	double				m_dAimFramePeriod	= 0.100;	// s between simulated vision frames of the hub.
+};
+
+const double dSimAimStart = 0.500;		// s into autonomous the hub first comes into view.
+
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CSimScenario class definition. Enables autonomous with the
+					scenario's path, runs the sim accelerated for the length of
+					the period and writes one JSON line of results: final pose
+					error, time to first shot and balls scored. A heading lock
+					scenario feeds the target tracker simulated hub frames
+					instead, aims the way teleop does and adds the settle time.
+	Arguments:		const sSimScenario& Scenario
+					CRobotSim* pRobotSim
+					CDrive* pDrive
+					CTargetTracker* pTargetTracker
+	Derived From:	Nothing
+******************************************************************************/
+class CSimScenario
+{
+public:
+	CSimScenario(const sSimScenario& Scenario, CRobotSim* pRobotSim, CDrive* pDrive, CTargetTracker* pTargetTracker);
+	void Start();
+	bool Tick();
+
+	static bool FromEnvironment(sSimScenario& Scenario);
+
+	// One-line methods.
+	Paths	GetPath()		{	return m_Scenario.m_nPath;	};
+
+private:
+	void WriteResult();
+	void TickAim();
+
+	sSimScenario		m_Scenario;
+	CRobotSim*			m_pRobotSim;
+	CDrive*				m_pDrive;
+	CTargetTracker*		m_pTargetTracker;
+	CVisionPacket		m_AimFrame;						// Reused for every simulated hub frame.
+	bool				m_bFinished;
+	double				m_dAimHeading;					// Gyro heading that faces the hub, set by the first frame.
+	double				m_dLastFrameTime;				// Elapsed time of the last simulated frame (s), negative before the first.
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
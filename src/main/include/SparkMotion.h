@@ -9,6 +9,7 @@
 #include <rev/CANSparkMax.h>
 #include <frc/Timer.h>
 #include "IOMap.h"
+#include "StatusFramePlanner.h"
 
 using namespace rev;
 using namespace frc;
@@ -77,6 +78,7 @@ public:
 
     // One-line Methods.
     CANSparkMax*	GetMotorPointer()			    	{ return m_pMotor;														};
+    int		AddToStatusFramePlan(CStatusFramePlanner* pPlanner)	{ return pPlanner->AddSpark(m_pMotor);							};
     bool	IsReady()									{ return m_bReady;														};
     bool	IsHomingComplete()							{ return m_bHomingComplete;												};
     void	SetMaxHomingTime(double dMaxHomingTime)		{ m_dMaxHomingTime = dMaxHomingTime;									};
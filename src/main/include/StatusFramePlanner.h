@@ -0,0 +1,99 @@
+/******************************************************************************
+	Description:	Defines the CStatusFramePlanner CAN bus budget class
+	Classes:		CStatusFramePlanner
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef StatusFramePlanner_h
+#define StatusFramePlanner_h
+
+#include <vector>
+#include <ctre/phoenix/motorcontrol/can/BaseTalon.h>
+#include <rev/CANSparkMax.h>
+
+using namespace ctre::phoenix::motorcontrol::can;
+using namespace rev;
+using namespace std;
+
+const double	dCanBitRate				= 1000000.000;	// roboRIO CAN bus, bits per second.
+const int		nCanPayloadBytes		= 8;			// Every status and control frame we plan for is a full frame.
+const int		nCanHeartbeatPeriod		= 20;			// roboRIO heartbeat broadcast (ms).
+const int		nPhoenixControlPeriod	= 10;			// Phoenix control frame, sent per Talon (ms).
+const int		nSparkControlPeriod		= 20;			// Spark MAX setpoint frame, sent per Spark at the loop rate (ms).
+const int		nPhoenixMaxFramePeriod	= 255;			// Longest period Phoenix 5 accepts (ms).
+const int		nStatusFrameMaxFrames	= 10;			// Most status frames on any device type.
+
+// CAN device types on the bus.
+enum CanDeviceType : int {
+	eCanTalonFX = 0,
+	eCanTalonSRX,
+	eCanSparkMax
+};
+
+// Signals a subsystem can ask for, each one lives in exactly one status frame per device type.
+enum StatusSignal : int {
+	eSignalOutput = 0,			// Applied output. Followers read this from their leader, so leaders need it fast.
+	eSignalLimitSwitch,
+	eSignalVelocity,
+	eSignalPosition,
+	eSignalCurrent,
+	eSignalTemperature,			// Temperature and bus voltage.
+	eSignalCount
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CStatusFramePlanner class definition. Subsystems add their
+					motor controllers and say which signals they read and how
+					often; Apply() sets every status frame to the slowest
+					period that still meets its readers and reports the
+					projected bus utilization against the defaults.
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CStatusFramePlanner
+{
+public:
+	// One status frame on a device type.
+	struct sStatusFrame {
+		int			m_nFrame;				// StatusFrameEnhanced or CANSparkMaxLowLevel::PeriodicFrame value.
+		int			m_nDefaultPeriod;		// Factory period (ms).
+		int			m_nIdlePeriod;			// Period used when nothing reads the frame (ms).
+		unsigned	m_nSignals;				// Bit per StatusSignal carried in the frame.
+	};
+
+	int AddTalon(BaseTalon* pTalon, CanDeviceType nType);
+	int AddSpark(CANSparkMax* pSpark);
+	void Require(int nDevice, StatusSignal nSignal, int nPeriod);
+	void Apply();
+	void Publish();
+
+	static double GetFrameBits(int nPayloadBytes);
+	static double GetUtilization(const vector<int>& vPeriods);
+
+	// One-line methods.
+	double	GetDefaultUtilization()		{	return m_dDefaultUtilization;	};
+	double	GetPlannedUtilization()		{	return m_dPlannedUtilization;	};
+
+private:
+	// One device and what's been asked of it, periods in ms with zero meaning not read.
+	struct sCanDevice {
+		CanDeviceType	m_nType;
+		BaseTalon*		m_pTalon;
+		CANSparkMax*	m_pSpark;
+		int				m_anSignalPeriod[eSignalCount];
+		int				m_anFramePeriod[nStatusFrameMaxFrames];
+	};
+
+	static const sStatusFrame* GetFrameTable(CanDeviceType nType, int& nFrameCount);
+	int AddDevice(CanDeviceType nType, BaseTalon* pTalon, CANSparkMax* pSpark);
+	void Plan(sCanDevice& Device);
+	void Configure(const sCanDevice& Device);
+
+	vector<sCanDevice>		m_vDevices;
+	double					m_dDefaultUtilization	= 0.000;
+	double					m_dPlannedUtilization	= 0.000;
+	int						m_nPlannedFramesPerSecond	= 0;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,86 @@
+/******************************************************************************
+	Description:	Defines the CTargetTracker multi-frame vision tracker
+	Classes:		CTargetTracker
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef TargetTracker_h
+#define TargetTracker_h
+
+#include "Vision.h"
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using namespace std;
+
+const int nTrackerMaxTracks				= 16;
+const int nTrackerConfirmHits			= 2;		// Frames a track needs before anything acts on it.
+const double dTrackerGateBearing		= 6.000;	// Furthest a detection can be from a track's prediction (degrees)...
+const double dTrackerGateDepth			= 750.000;	// ...and (mm), to be matched to it.
+const double dTrackerAlpha				= 0.500;	// Alpha-beta filter gains, position then rate.
+const double dTrackerBeta				= 0.150;
+const double dTrackerCoastTime			= 0.500;	// Unmatched tracks are dropped after this long (s), see Expire().
+
+// One tracked target. Bearings are continuous gyro headings, so a track holds still while the robot turns.
+struct sTargetTrack {
+	int					m_nID			= 0;			// Stable for the life of the track, zero for a free slot.
+	DetectionClass		m_kClass		= eCargo;
+	DetectionLocation	m_kLocation		= eNONE;
+	int					m_nHits			= 0;
+	double				m_dBearing		= 0.000;		// Heading that points the camera at the target (degrees).
+	double				m_dBearingRate	= 0.000;		// deg/s
+	double				m_dDepth		= 0.000;		// mm, zero if the coprocessor never sent one.
+	double				m_dDepthRate	= 0.000;		// mm/s
+	double				m_dWidth		= 0.000;		// pixels
+	double				m_dLastSeen		= 0.000;		// Capture time of the last matched frame (s).
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CTargetTracker class definition. Matches each new frame's
+					detections to the tracks from earlier frames by class,
+					camera, bearing and depth, and smooths every matched track
+					with an alpha-beta filter. Tracks live in one fixed table,
+					so a noisy frame nudges a track instead of replacing the
+					target, and callers can keep a track by its ID.
+	Arguments:		CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CTargetTracker
+{
+public:
+	CTargetTracker(CTelemetry* pTelemetry);
+	void Update(const CVisionPacket* pPacket, double dHeading);
+	void Expire(double dNow);
+	void Reset();
+	const sTargetTrack* GetBest(DetectionClass kClass) const;
+	const sTargetTrack* GetTrack(int nID) const;
+	void Publish();
+
+	// One-line methods, predictions stop extrapolating once a track has coasted as long as it's allowed to.
+	static double	PredictBearing(const sTargetTrack& Track, double dTime)	{	return Track.m_dBearing + (Track.m_dBearingRate * min(dTime - Track.m_dLastSeen, dTrackerCoastTime));	};
+	static double	PredictDepth(const sTargetTrack& Track, double dTime)	{	return Track.m_dDepth + (Track.m_dDepthRate * min(dTime - Track.m_dLastSeen, dTrackerCoastTime));		};
+
+private:
+	// A detection and track close enough to be the same target.
+	struct sCandidate {
+		double		m_dCost;
+		int			m_nDetection;
+		int			m_nTrack;
+	};
+
+	array<sTargetTrack, nTrackerMaxTracks>	m_aTracks;
+	vector<sCandidate>						m_vCandidates;		// Reserved once, refilled every frame.
+	int										m_nNextID;
+	double									m_dLastFrame;		// Capture time of the last frame used (s).
+
+	// Telemetry handles.
+	CTelemetry*								m_pTelemetry;
+	int										m_nTracksHandle;
+	int										m_nHubTrackHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
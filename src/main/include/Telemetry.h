@@ -0,0 +1,53 @@
+/******************************************************************************
+	Description:	Defines the CTelemetry dashboard publisher
+	Classes:		CTelemetry
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef Telemetry_h
+#define Telemetry_h
+
+#include <string>
+#include <vector>
+#include <networktables/NetworkTableEntry.h>
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CTelemetry class definition. Subsystems register their
+					dashboard values once and keep the returned handle; values
+					are written into flat arrays every loop and Flush() only
+					publishes the ones that moved past their deadband.
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CTelemetry
+{
+public:
+	CTelemetry();
+	~CTelemetry();
+	int RegisterNumber(const char* pszKey, double dDeadband = 0.000);
+	int RegisterBoolean(const char* pszKey);
+	void Flush();
+
+	// One-line methods.
+	void SetNumber(int nHandle, double dValue)		{	m_vValues[nHandle] = dValue;				};
+	void SetBoolean(int nHandle, bool bValue)		{	m_vValues[nHandle] = bValue ? 1.000 : 0.000;	};
+
+private:
+	int Register(const char* pszKey, double dDeadband, bool bBoolean);
+
+	// Struct of arrays, indexed by handle.
+	vector<string>					m_vKeys;
+	vector<nt::NetworkTableEntry>	m_vEntries;
+	vector<double>					m_vValues;
+	vector<double>					m_vPublished;
+	vector<double>					m_vDeadbands;
+	vector<bool>					m_vBoolean;
+
+	int								m_nFlushTimeHandle;
+	int								m_nPublishCountHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
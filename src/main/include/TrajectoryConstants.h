@@ -11,6 +11,12 @@
 #include <frc/trajectory/TrajectoryConfig.h>
 #include <frc/trajectory/Trajectory.h>
 #include <frc/trajectory/TrajectoryUtil.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <wpi/span.h>
 
 using namespace frc;
 using namespace units;
@@ -35,18 +41,56 @@ enum Paths : int {
 
 	eTerminator,
 };
+const int nPathCount = eTerminator + 1;
+
+// Paths that follow a deployed trajectory, everything else is time based.
+const Paths aTrajectoryPaths[] = {eTestPath, eAdvancement1, eAdvancement2};
+
+// Deployed path locations, under the deploy directory so the desktop tests find src/main/deploy.
+const char* const pszPathJsonDirectory		= "paths/output/";
+const char* const pszPathBinaryDirectory	= "paths/binary/";
+
+// Binary trajectory file, written by the generateBinaryPaths task in build.gradle.
+const uint32_t nBinaryTrajectoryMagic		= 0x424A5254;		// "TRJB" little endian.
+const uint32_t nBinaryTrajectoryVersion		= 1;
+struct sBinaryTrajectoryHeader {
+	uint32_t	m_nMagic;
+	uint32_t	m_nVersion;
+	uint32_t	m_nCount;
+	uint32_t	m_nReserved;
+};
+struct sBinaryTrajectoryState {
+	double		m_dTime;				// s
+	double		m_dVelocity;			// m/s
+	double		m_dAcceleration;		// m/s^2
+	double		m_dX;					// m
+	double		m_dY;					// m
+	double		m_dRotation;			// rad
+	double		m_dCurvature;			// rad/m
+};
+static_assert(sizeof(sBinaryTrajectoryHeader) == 16 && sizeof(sBinaryTrajectoryState) == 56, "Binary trajectory layout must match build.gradle");
 ///////////////////////////////////////////////////////////////////////////////
 
 class CTrajectoryConstants
 {
 public:
+	CTrajectoryConstants();
+	~CTrajectoryConstants();
+	void WarmCache();
+	shared_ptr<const Trajectory> GetTrajectory(int nSelection);
 	void SelectTrajectory(int nSelection);
 	void SelectTrajectory(Trajectory Path);
+	static const char* GetPathName(int nSelection);
+	static Trajectory LoadTrajectory(const char* pszName);
+	static bool LoadBinaryTrajectory(const string& strFile, Trajectory& Path);
+	static void BenchmarkLoaders();
 
 	// One-line methods.
-	Pose2d GetSelectedTrajectoryStartPoint()	{	return m_pSelectedPath->InitialPose();		};
-	Trajectory GetSelectedTrajectory()			{	return *m_pSelectedPath;						};
-	double GetSelectedTrajectoryTotalTime()		{	return (double)m_pSelectedPath->TotalTime();	};
+	Pose2d GetSelectedTrajectoryStartPoint()							{	return m_pSelectedPath->InitialPose();		};
+	const Trajectory& GetSelectedTrajectory()							{	return *m_pSelectedPath;						};
+	shared_ptr<const Trajectory> GetSelectedTrajectoryPointer()			{	return m_pSelectedPath;						};
+	span<const Trajectory::State> GetSelectedTrajectoryStates()		{	return m_pSelectedPath->States();				};
+	double GetSelectedTrajectoryTotalTime()								{	return (double)m_pSelectedPath->TotalTime();	};
 	static bool IsInShootingRange(double depth) {
 		
 		/*return (
@@ -61,7 +105,14 @@ public:
 	//const double m_dAutoShootingRange = 600;
 
 private:
-	Trajectory* m_pSelectedPath;
+	void LoadAll();
+
+	// Trajectory cache indexed by Paths, each slot is written once by the warm thread.
+	shared_ptr<const Trajectory>	m_apCache[nPathCount];
+	atomic<bool>					m_abReady[nPathCount];
+	thread							m_WarmThread;
+	bool							m_bLoaded;
+	shared_ptr<const Trajectory>	m_pSelectedPath;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+/******************************************************************************
+	Description:	Defines the CTrajectoryFollower Ramsete path follower
+	Classes:		CTrajectoryFollower
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef TrajectoryFollower_h
+#define TrajectoryFollower_h
+
+#include "Telemetry.h"
+
+#include <memory>
+#include <frc/Timer.h>
+#include <frc/controller/PIDController.h>
+#include <frc/controller/RamseteController.h>
+#include <frc/controller/SimpleMotorFeedforward.h>
+#include <frc/geometry/Pose2d.h>
+#include <frc/kinematics/DifferentialDriveKinematics.h>
+#include <frc/kinematics/DifferentialDriveWheelSpeeds.h>
+#include <frc/trajectory/Trajectory.h>
+
+using namespace frc;
+using namespace std;
+using namespace units;
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CTrajectoryFollower class definition. Same control law as
+					frc2::RamseteCommand::Execute(), but owned by CDrive for the
+					life of the robot and re-armed with a new trajectory instead
+					of being allocated per auto run.
+	Arguments:		DifferentialDriveKinematics Kinematics
+					SimpleMotorFeedforward<meters> Feedforward
+					double dProportional, double dIntegral, double dDerivative
+					second_t dPeriod - How often Calculate() is called
+					CTelemetry* pTelemetry
+	Derived From:	Nothing
+******************************************************************************/
+class CTrajectoryFollower
+{
+public:
+	CTrajectoryFollower(DifferentialDriveKinematics Kinematics, SimpleMotorFeedforward<meters> Feedforward, double dProportional, double dIntegral, double dDerivative, second_t dPeriod, CTelemetry* pTelemetry);
+	void Arm(shared_ptr<const Trajectory> pTrajectory);
+	void Disarm();
+	void Calculate(const Pose2d& Pose, const DifferentialDriveWheelSpeeds& ActualSpeeds, volt_t& dLeftVoltage, volt_t& dRightVoltage);
+	bool IsFinished();
+
+	// One-line methods.
+	bool IsArmed()		{	return m_pTrajectory != nullptr;	};
+
+private:
+	DifferentialDriveKinematics			m_Kinematics;
+	SimpleMotorFeedforward<meters>		m_Feedforward;
+	RamseteController					m_Controller;
+	frc2::PIDController					m_LeftController;
+	frc2::PIDController					m_RightController;
+	Timer								m_Timer;
+	shared_ptr<const Trajectory>		m_pTrajectory;
+	second_t							m_dPrevTime;			// Negative until the first Calculate() after Arm().
+	DifferentialDriveWheelSpeeds		m_PrevSpeeds;
+
+	// Telemetry handles.
+	CTelemetry*							m_pTelemetry;
+	int									m_nErrorXHandle;
+	int									m_nErrorYHandle;
+	int									m_nErrorHeadingHandle;
+	int									m_nLeftSpeedErrorHandle;
+	int									m_nRightSpeedErrorHandle;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -9,6 +9,9 @@
 #define Transfer_h
 
 #include "IOMap.h"
+#include "StatusFramePlanner.h"
+#include "SensorSnapshot.h"
+#include "CommandCache.h"
 
 #include <rev/CANSparkMax.h>
 #include <frc/DigitalInput.h>
@@ -28,7 +31,7 @@ class CTransfer
 {
 public:
 	// Declare class methods.
-	CTransfer();
+	CTransfer(const sSensorSnapshot* pSnapshot, CCommandCache* pCommandCache);
 	~CTransfer();
 	void Init();
 	void StartVertical();
@@ -37,6 +40,12 @@ public:
 	void StopVertical();
 	void StopBack();
 	void UpdateLocations();
+	void ConfigureStatusFrames(CStatusFramePlanner* pPlanner);
+	void ReadSensors(sSensorSnapshot& Snapshot);
+
+	// One-line methods.
+	double	GetVerticalOutput()		{	return m_pTopMotor->Get();		};
+	double	GetBackOutput()			{	return m_pBackMotor->Get();		};
 
 	// Arranged Vertical, Back
 	bool m_aBallLocations[2] = {false, false};
@@ -44,6 +53,10 @@ private:
 	// Declare class objects and variables.
 	DigitalInput*		m_pTopInfrared;
 	DigitalInput*		m_pBackInfrared;
+	const sSensorSnapshot*	m_pSnapshot;
+	CCommandCache*		m_pCommandCache;
+	int					m_nTopCommand;
+	int					m_nBackCommand;
 
 	CANSparkMax*		m_pTopMotor;
 	CANSparkMax*		m_pBackMotor;
@@ -1,13 +1,26 @@
 /******************************************************************************
 	Description:	Defines the CVisionPacket control class
-	Classes:		CVisionPacket 
+	Classes:		CDetectionBatch, CVisionPacket
 	Project:		2022 Rapid React Robot Code
 ******************************************************************************/
 
 #ifndef Vision_h
-#define Vison_h
+#define Vision_h
+
+#include "VisionProtocol.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
 
 const double dAnglePerPixel = 69.000 / 320.000;
+// Version 1 packets, see VisionProtocol.h for version 2.
+const int nVisionHeaderSize			= 3;		// Random value, detection count, camera location.
+const int nVisionDetectionSize		= 14;		// Serialized size of a single detection.
+const int nVisionMaxPacketSize		= nVisionProtocolMaxPacketSize;
+static_assert(nVisionMaxPacketSize >= nVisionHeaderSize + (nVisionMaxDetections * nVisionDetectionSize), "Version 1 packets must fit the raw buffer");
+const double dVisionPipelineLatency	= 0.050;	// Estimated camera capture to NetworkTables publish time on the coprocessor (s).
+
 enum DetectionClass : unsigned char {
     eCargo = 0x00, // Note: This shouldn't really be used; It's fairly exclusive to the network.
     //eBlueHangar,
@@ -23,53 +36,137 @@ enum DetectionLocation : unsigned char {
     eNONE  = 0xFF
 };
 
+const int nDetectionBatchCapacity	= 256;		// nVisionMaxDetections rounded up to whole vectors.
+static_assert(nDetectionBatchCapacity >= nVisionMaxDetections, "A batch must hold a whole packet");
+
+// One byte per detection in a CDetectionBatch, 1 where it matched. Only the first
+// m_nCount are valid, combine masks from the same batch with & and |. The loops run
+// over the whole capacity, a fixed trip count is what lets them vectorize at -O2.
+struct sDetectionMask {
+	int					m_nCount = 0;
+	alignas(16) uint8_t	m_anMatch[nDetectionBatchCapacity];
+
+	// Index of the first match at or after nIndex, -1 if there is none.
+	int Next(int nIndex) const {
+		for (; nIndex < m_nCount; nIndex++) if (m_anMatch[nIndex]) return nIndex;
+		return -1;
+	}
+
+	sDetectionMask operator&(const sDetectionMask& Other) const {
+		sDetectionMask Mask;
+		Mask.m_nCount = std::min(m_nCount, Other.m_nCount);
+		for (int n = 0; n < nDetectionBatchCapacity; n++) Mask.m_anMatch[n] = m_anMatch[n] & Other.m_anMatch[n];
+		return Mask;
+	}
+
+	sDetectionMask operator|(const sDetectionMask& Other) const {
+		sDetectionMask Mask;
+		Mask.m_nCount = std::min(m_nCount, Other.m_nCount);
+		for (int n = 0; n < nDetectionBatchCapacity; n++) Mask.m_anMatch[n] = m_anMatch[n] | Other.m_anMatch[n];
+		return Mask;
+	}
+};
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CDetectionBatch class definition. A packet's detections as
+					one array per field, decoded in a single pass that reads
+					each record with two byte swapped 64 bit loads. The Match
+					kernels compare one field each with no branches, which
+					the compiler turns into vector compares, and return a
+					mask, so a consumer picks out what it wants once instead
+					of scanning every detection per class.
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CDetectionBatch
+{
+public:
+	CDetectionBatch();
+	void Decode(const unsigned char* pDetections, int nVersion, int nCount);
+	sDetectionMask MatchClass(DetectionClass kClass) const;
+	sDetectionMask MatchConfidence(uint8_t nMinimum) const;
+	sDetectionMask MatchBearing(double dMinimum, double dMaximum) const;
+
+	static void Benchmark();
+
+	// One-line methods.
+	double	GetBearing(int nIndex) const	{	return (m_anX[nIndex] - 160) * dAnglePerPixel;	};		// Degrees right of the camera's center.
+
+	int						m_nCount;
+	alignas(16) uint16_t	m_anX[nDetectionBatchCapacity];
+	alignas(16) uint16_t	m_anY[nDetectionBatchCapacity];
+	alignas(16) uint16_t	m_anWidth[nDetectionBatchCapacity];
+	alignas(16) uint16_t	m_anHeight[nDetectionBatchCapacity];
+	alignas(16) uint8_t		m_anConfidence[nDetectionBatchCapacity];
+	alignas(16) uint8_t		m_anClass[nDetectionBatchCapacity];			// DetectionClass
+	alignas(16) int32_t		m_anDepth[nDetectionBatchCapacity];			// mm, zero or less when unknown.
+
+private:
+	template<int nStride> void DecodeRecords(const unsigned char* pDetections, int nCount);
+	template<typename Predicate> sDetectionMask BuildMask(Predicate Match) const;
+};
+///////////////////////////////////////////////////////////////////////////////
+
 class CVisionPacket {
 public:
     CVisionPacket();
-    CVisionPacket(const char* pPacketArr, unsigned int length);
-    ~CVisionPacket();
+    bool Decode(const char* pPacketArr, unsigned int nLength);
     void ParseDetections();
-    static CVisionPacket* GetReceivedPacket();
+    void ParseBatch();
 
-    unsigned char m_nRandVal = 0xFF;
+    unsigned char m_nRandVal = 0xFF;    // Changes every packet, 0xFF when invalid. Derived from the sequence for version 2.
     unsigned char m_nDetectionCount = 0xFF;
     DetectionLocation m_kDetectionLocation = DetectionLocation::eNONE;
+    double m_dTimestamp = 0.000;        // Estimated capture time on the FPGA clock (s).
+    uint8_t m_nVersion = 0;             // Wire protocol version, 1 for the original packets.
+    uint32_t m_nSequence = 0;           // Version 2 only.
+    uint64_t m_nCaptureTime = 0;        // Version 2 only, coprocessor clock (us). CVisionIngest maps it into m_dTimestamp.
 
-    // Force the compiler to pack tightly in order to properly deserialize this
-    #pragma pack(1)
     struct sObjectDetection {
         public:
-        short           m_nX;
-        short           m_nY;
+        uint16_t        m_nX;
+        uint16_t        m_nY;
 
-        short           m_nWidth;
-        short           m_nHeight;
+        uint16_t        m_nWidth;
+        uint16_t        m_nHeight;
 
-        char            m_nConfidence;
+        uint8_t         m_nConfidence;
         DetectionClass  m_kClass;
-        int             m_nDepth;
-
-        sObjectDetection(const char* arr, int offset = 0) {
-			m_nX = (short) (arr[offset] << 8 | arr[offset + 1]);
-			m_nY = (short) (arr[offset + 2] << 8 | arr[offset + 3]);
-			m_nWidth = (short) (arr[offset + 4] << 8 | arr[offset + 5]);
-			m_nHeight = (short) (arr[offset + 6] << 8 | arr[offset + 7]);
-			m_nConfidence = (arr[offset + 8]);
-			m_kClass = (DetectionClass)(arr[offset + 9]);
-            
-            // Convert the big endian data in the byte array into the int
-            m_nDepth = 0;
-            for(unsigned int n = 0; n < sizeof(m_nDepth); n++) {
-                m_nDepth = (m_nDepth << 8) + arr[(offset + 10) + n];
-            }
+        int             m_nDepth;           // mm, zero or less when unknown.
+
+        // Decode a version 1 big endian detection in place, starting at offset in the raw packet.
+        void Decode(const unsigned char* arr, int offset = 0) {
+            m_nX = LoadBigEndian16(arr + offset);
+            m_nY = LoadBigEndian16(arr + offset + 2);
+            m_nWidth = LoadBigEndian16(arr + offset + 4);
+            m_nHeight = LoadBigEndian16(arr + offset + 6);
+            m_nConfidence = arr[offset + 8];
+            m_kClass = (DetectionClass)(arr[offset + 9]);
+            m_nDepth = (int)LoadBigEndian32(arr + offset + 10);
+        }
+
+        // Copy one detection out of a validated version 2 packet.
+        void Decode(const CVisionPacketView& View, int nIndex) {
+            m_nX = View.GetX(nIndex);
+            m_nY = View.GetY(nIndex);
+            m_nWidth = View.GetWidth(nIndex);
+            m_nHeight = View.GetHeight(nIndex);
+            m_nConfidence = View.GetConfidence(nIndex);
+            m_kClass = (DetectionClass)View.GetClass(nIndex);
+            m_nDepth = (int)std::min<uint32_t>(View.GetDepth(nIndex), INT32_MAX);
         }
     };
-    #pragma pack(0)
-    
-    sObjectDetection** m_pDetections;
 
-    // Allocate the extra data buffer at the end
-    char* m_pRawPacket;
+    // Detections are decoded in place by ParseDetections(), only the first m_nDetectionCount are valid.
+    std::array<sObjectDetection, nVisionMaxDetections> m_aDetections;
+
+    // The same detections one array per field, filled by ParseBatch(). This is what the robot loop reads.
+    CDetectionBatch m_Batch;
+
+    // Fixed size copy of the raw packet so decoding never touches the heap.
+    unsigned int  m_nRawLength;
+    unsigned char m_aRawPacket[nVisionMaxPacketSize];
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,86 @@
+/******************************************************************************
+	Description:	Defines the CVisionIngest background receive class
+	Classes:		CVisionIngest
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef VisionIngest_h
+#define VisionIngest_h
+
+#include "Vision.h"
+#include "LatestValue.h"
+#include "Telemetry.h"
+
+#include <atomic>
+#include <thread>
+#include <networktables/NetworkTableEntry.h>
+#include <networktables/NetworkTableInstance.h>
+#include <ntcore_cpp.h>
+
+// Version 2 capture times are put on the FPGA clock through a running clock offset.
+const double dVisionClockDrift		= 0.0001;	// s per s the offset floor creeps up, covers 100 ppm of crystal drift.
+const double dVisionClockResync		= 1.000;	// s, an offset jump this large means the coprocessor restarted.
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CVisionIngest class definition. Listens to the coprocessor's
+					processed_vision entry on its own thread, decodes every
+					packet there, and hands the newest one to the robot loop.
+	Arguments:		None
+	Derived From:	Nothing
+******************************************************************************/
+class CVisionIngest
+{
+public:
+	CVisionIngest(CTelemetry* pTelemetry);
+	~CVisionIngest();
+	void Start(nt::NetworkTableInstance Instance = nt::NetworkTableInstance::GetDefault());
+	void Stop();
+	const CVisionPacket* GetLatestPacket();
+	void PublishStatistics();
+
+	// Ingest statistics, all times in microseconds.
+	struct sIngestStatistics {
+		unsigned int	m_nFrames			= 0;
+		unsigned int	m_nRejected			= 0;		// Failed the length or CRC check.
+		unsigned int	m_nDropped			= 0;		// Version 2 sequence numbers never received.
+		double			m_dLatencyMean		= 0.000;	// NetworkTables update to decoded packet.
+		double			m_dLatencyMax		= 0.000;
+		double			m_dIntervalMean		= 0.000;	// Time between consecutive packets.
+		double			m_dIntervalJitter	= 0.000;	// Standard deviation of the interval.
+	};
+
+private:
+	void IngestThread();
+	void RecordFrame(double dLatency, double dInterval);
+	void RecordSequence(const CVisionPacket& Packet);
+	double MapCaptureTime(const CVisionPacket& Packet, uint64_t nChange);
+
+	std::thread							m_Thread;
+	std::atomic<bool>					m_bRunning;
+	nt::NetworkTableEntry				m_Entry;
+	NT_EntryListenerPoller				m_hPoller;
+	NT_EntryListener					m_hListener;
+	CLatestValue<CVisionPacket>			m_LatestPacket;
+	CLatestValue<sIngestStatistics>		m_Statistics;
+	bool								m_bHasPacket;
+	CTelemetry*							m_pTelemetry;
+	int									m_nFramesHandle;
+	int									m_nRejectedHandle;
+	int									m_nDroppedHandle;
+	int									m_nLatencyMeanHandle;
+	int									m_nLatencyMaxHandle;
+	int									m_nIntervalMeanHandle;
+	int									m_nIntervalJitterHandle;
+
+	// Running sums, only touched by the ingest thread.
+	sIngestStatistics					m_RunningStatistics;
+	double								m_dIntervalM2;
+	uint64_t							m_nLastChange;
+	uint32_t							m_nLastSequence;
+	bool								m_bHasSequence;
+	int64_t								m_nClockOffset;		// Smallest FPGA arrival minus coprocessor capture time (us).
+	bool								m_bHasClockOffset;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,169 @@
+/******************************************************************************
+	Description:	Defines the vision coprocessor wire protocol
+	Classes:		CVisionPacketView
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#ifndef VisionProtocol_h
+#define VisionProtocol_h
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#endif
+
+/******************************************************************************
+	Version 2 packet, every field is unsigned and big endian. The coprocessor
+	side of this layout is tools/vision_protocol.py, change both together and
+	bump the version.
+
+	Both versions arrive on the same entry. A version 1 packet starts with its
+	random value, which is never 0xFF on a valid packet, so the magic starts
+	with 0xFF and can't be mistaken for one. A version 1 packet that does start
+	0xFF 0x56 was invalid anyway and fails the version 2 checks instead.
+
+	Header, nVisionProtocolHeaderSize bytes
+		0	u16		Magic, nVisionProtocolMagic
+		2	u8		Version, nVisionProtocolVersion
+		3	u8		Camera location, DetectionLocation
+		4	u32		Sequence, one more than the previous frame, wraps
+		8	u64		Capture time on the coprocessor clock (us), any
+					monotonic clock, the robot works out the offset
+		16	u16		Detection count, at most nVisionMaxDetections
+		18	u16		Detection size, nVisionProtocolDetectionSize
+	Detections, count times nVisionProtocolDetectionSize bytes
+		0	u16		Center x (pixels)
+		2	u16		Center y (pixels)
+		4	u16		Width (pixels)
+		6	u16		Height (pixels)
+		8	u8		Confidence, 255 is certain
+		9	u8		Class, DetectionClass
+		10	u16		Reserved, zero
+		12	u32		Depth (mm), zero when unknown
+	Trailer, nVisionProtocolTrailerSize bytes
+		0	u32		CRC-32 (IEEE 802.3, same as zlib.crc32) of every byte
+					before it
+******************************************************************************/
+const int		nVisionMaxDetections			= 255;		// Both versions, the first sent the count as a single byte.
+const uint16_t	nVisionProtocolMagic			= 0xFF56;	// 0xFF then "V", see above.
+const uint8_t	nVisionProtocolVersion			= 2;
+
+// Header offsets.
+const int		nVisionHeaderMagic				= 0;
+const int		nVisionHeaderVersion			= 2;
+const int		nVisionHeaderLocation			= 3;
+const int		nVisionHeaderSequence			= 4;
+const int		nVisionHeaderCaptureTime		= 8;
+const int		nVisionHeaderCount				= 16;
+const int		nVisionHeaderDetectionSize		= 18;
+const int		nVisionProtocolHeaderSize		= 20;
+// Detection offsets.
+const int		nVisionDetectionX				= 0;
+const int		nVisionDetectionY				= 2;
+const int		nVisionDetectionWidth			= 4;
+const int		nVisionDetectionHeight			= 6;
+const int		nVisionDetectionConfidence		= 8;
+const int		nVisionDetectionClass			= 9;
+const int		nVisionDetectionReserved		= 10;
+const int		nVisionDetectionDepth			= 12;
+const int		nVisionProtocolDetectionSize	= 16;
+const int		nVisionProtocolTrailerSize		= 4;
+const int		nVisionProtocolMaxPacketSize	= nVisionProtocolHeaderSize + (nVisionMaxDetections * nVisionProtocolDetectionSize) + nVisionProtocolTrailerSize;
+
+// Each field ends where the next one starts.
+static_assert(nVisionHeaderVersion == nVisionHeaderMagic + sizeof(uint16_t), "Vision header layout");
+static_assert(nVisionHeaderLocation == nVisionHeaderVersion + sizeof(uint8_t), "Vision header layout");
+static_assert(nVisionHeaderSequence == nVisionHeaderLocation + sizeof(uint8_t), "Vision header layout");
+static_assert(nVisionHeaderCaptureTime == nVisionHeaderSequence + sizeof(uint32_t), "Vision header layout");
+static_assert(nVisionHeaderCount == nVisionHeaderCaptureTime + sizeof(uint64_t), "Vision header layout");
+static_assert(nVisionHeaderDetectionSize == nVisionHeaderCount + sizeof(uint16_t), "Vision header layout");
+static_assert(nVisionProtocolHeaderSize == nVisionHeaderDetectionSize + sizeof(uint16_t), "Vision header layout");
+static_assert(nVisionDetectionY == nVisionDetectionX + sizeof(uint16_t), "Vision detection layout");
+static_assert(nVisionDetectionWidth == nVisionDetectionY + sizeof(uint16_t), "Vision detection layout");
+static_assert(nVisionDetectionHeight == nVisionDetectionWidth + sizeof(uint16_t), "Vision detection layout");
+static_assert(nVisionDetectionConfidence == nVisionDetectionHeight + sizeof(uint16_t), "Vision detection layout");
+static_assert(nVisionDetectionClass == nVisionDetectionConfidence + sizeof(uint8_t), "Vision detection layout");
+static_assert(nVisionDetectionReserved == nVisionDetectionClass + sizeof(uint8_t), "Vision detection layout");
+static_assert(nVisionDetectionDepth == nVisionDetectionReserved + sizeof(uint16_t), "Vision detection layout");
+static_assert(nVisionProtocolDetectionSize == nVisionDetectionDepth + sizeof(uint32_t), "Vision detection layout");
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "The vision protocol loads assume a little endian host"
+#endif
+
+// Unaligned big endian loads. The memcpy is legal at any offset and compiles
+// down to one load and a byte swap.
+inline uint16_t LoadBigEndian16(const unsigned char* pData)
+{
+	uint16_t nValue;
+	memcpy(&nValue, pData, sizeof(nValue));
+#if defined(_MSC_VER)
+	return _byteswap_ushort(nValue);
+#else
+	return __builtin_bswap16(nValue);
+#endif
+}
+
+inline uint32_t LoadBigEndian32(const unsigned char* pData)
+{
+	uint32_t nValue;
+	memcpy(&nValue, pData, sizeof(nValue));
+#if defined(_MSC_VER)
+	return _byteswap_ulong(nValue);
+#else
+	return __builtin_bswap32(nValue);
+#endif
+}
+
+inline uint64_t LoadBigEndian64(const unsigned char* pData)
+{
+	uint64_t nValue;
+	memcpy(&nValue, pData, sizeof(nValue));
+#if defined(_MSC_VER)
+	return _byteswap_uint64(nValue);
+#else
+	return __builtin_bswap64(nValue);
+#endif
+}
+
+uint32_t VisionCrc32(const unsigned char* pData, size_t nLength);
+///////////////////////////////////////////////////////////////////////////////
+
+/******************************************************************************
+	Description:	CVisionPacketView class definition. Reads a version 2
+					packet where it lies, nothing is copied. Validate() makes
+					the one length, magic, version and CRC check, after that
+					the accessors read straight from the buffer without any
+					further bounds checks.
+	Arguments:		const unsigned char* pData, size_t nLength
+	Derived From:	Nothing
+******************************************************************************/
+class CVisionPacketView
+{
+public:
+	CVisionPacketView(const unsigned char* pData, size_t nLength);
+	bool Validate() const;
+
+	// One-line methods.
+	uint8_t					GetVersion() const				{	return m_pData[nVisionHeaderVersion];									};
+	uint8_t					GetLocation() const				{	return m_pData[nVisionHeaderLocation];									};
+	uint32_t				GetSequence() const				{	return LoadBigEndian32(m_pData + nVisionHeaderSequence);				};
+	uint64_t				GetCaptureTime() const			{	return LoadBigEndian64(m_pData + nVisionHeaderCaptureTime);				};
+	int						GetDetectionCount() const		{	return LoadBigEndian16(m_pData + nVisionHeaderCount);					};
+	const unsigned char*	GetDetection(int nIndex) const	{	return m_pData + nVisionProtocolHeaderSize + (nIndex * nVisionProtocolDetectionSize);	};
+	uint16_t				GetX(int nIndex) const			{	return LoadBigEndian16(GetDetection(nIndex) + nVisionDetectionX);		};
+	uint16_t				GetY(int nIndex) const			{	return LoadBigEndian16(GetDetection(nIndex) + nVisionDetectionY);		};
+	uint16_t				GetWidth(int nIndex) const		{	return LoadBigEndian16(GetDetection(nIndex) + nVisionDetectionWidth);	};
+	uint16_t				GetHeight(int nIndex) const		{	return LoadBigEndian16(GetDetection(nIndex) + nVisionDetectionHeight);	};
+	uint8_t					GetConfidence(int nIndex) const	{	return GetDetection(nIndex)[nVisionDetectionConfidence];				};
+	uint8_t					GetClass(int nIndex) const		{	return GetDetection(nIndex)[nVisionDetectionClass];					};
+	uint32_t				GetDepth(int nIndex) const		{	return LoadBigEndian32(GetDetection(nIndex) + nVisionDetectionDepth);	};
+
+private:
+	const unsigned char*	m_pData;
+	size_t					m_nLength;
+};
+///////////////////////////////////////////////////////////////////////////////
+#endif
@@ -0,0 +1,100 @@
+/******************************************************************************
+	Description:	Runs a whole autonomous routine headless in the desktop
+					simulation and checks where it ends up
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "RobotMain.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+const char* const	pszScenarioResultFile	= "sim_scenario_test.jsonl";
+const double		dScenarioMaxOdometryError	= 0.050;	// m between odometry and the simulated pose.
+const double		dScenarioMinBackup			= 0.500;	// m the taxi has to end up behind where it started.
+const double		dScenarioAimStep			= 15.000;	// degrees, well inside the camera's view.
+const double		dScenarioMaxAimSettle		= 0.750;	// s, the profile alone needs 0.29 s for the step.
+
+/******************************************************************************
+	Description:	Read one number out of a CSimScenario result line
+	Arguments:		const string& strResult, const char* pszKey
+	Returns:		double - Value, NaN if the key is missing
+******************************************************************************/
+static double GetResultNumber(const string& strResult, const char* pszKey)
+{
+	const string strKey = string("\"") + pszKey + "\": ";
+	const size_t nStart = strResult.find(strKey);
+	if (nStart == string::npos) return nan("");
+	return atof(strResult.c_str() + nStart + strKey.size());
+}
+
+// Same as tools/sim_batch.py, a nominal robot with the one field ball the route picks up.
+// Autonomous is stepped faster than real time and EndCompetition() returns once it's over.
+TEST(SimScenarioTest, Taxi2ShotScoresBoth)
+{
+	remove(pszScenarioResultFile);
+	setenv("SIM_PATH", to_string((int)eTaxi2Shot).c_str(), 1);
+	setenv("SIM_FIELD_BALLS", "1", 1);
+	setenv("SIM_RESULT", pszScenarioResultFile, 1);
+
+	CRobotMain* pRobot = new CRobotMain();
+	thread RobotThread([pRobot] { pRobot->StartCompetition(); });
+	RobotThread.join();
+	delete pRobot;
+
+	unsetenv("SIM_PATH");
+	unsetenv("SIM_FIELD_BALLS");
+	unsetenv("SIM_RESULT");
+
+	ifstream Result(pszScenarioResultFile);
+	string strResult;
+	ASSERT_TRUE((bool)getline(Result, strResult)) << "the scenario wrote no result";
+
+	// A timed path has no trajectory end point (pose_error is -1), so check odometry against
+	// the simulated pose and that the robot backed off the line.
+	EXPECT_LT(GetResultNumber(strResult, "odometry_error"), dScenarioMaxOdometryError);
+	EXPECT_LT(GetResultNumber(strResult, "x"), -dScenarioMinBackup);
+	EXPECT_EQ(GetResultNumber(strResult, "balls_fired"), 2);
+	EXPECT_EQ(GetResultNumber(strResult, "balls_scored"), 2);
+	EXPECT_GT(GetResultNumber(strResult, "first_shot_time"), 0.000);
+	remove(pszScenarioResultFile);
+}
+
+// Same as tools/sim_batch.py --aim, hub frames go through the target tracker and the drive
+// locks onto the track's predicted bearing, with the models stepped every fast tier tick.
+TEST(SimScenarioTest, AimSettlesOnTheHub)
+{
+	remove(pszScenarioResultFile);
+	setenv("SIM_PATH", to_string((int)eAutoIdle).c_str(), 1);
+	setenv("SIM_FIELD_BALLS", "0", 1);
+	setenv("SIM_AIM", to_string(dScenarioAimStep).c_str(), 1);
+	setenv("SIM_DURATION", "3.0", 1);
+	setenv("SIM_RESULT", pszScenarioResultFile, 1);
+
+	CRobotMain* pRobot = new CRobotMain();
+	thread RobotThread([pRobot] { pRobot->StartCompetition(); });
+	RobotThread.join();
+	delete pRobot;
+
+	unsetenv("SIM_PATH");
+	unsetenv("SIM_FIELD_BALLS");
+	unsetenv("SIM_AIM");
+	unsetenv("SIM_DURATION");
+	unsetenv("SIM_RESULT");
+
+	ifstream Result(pszScenarioResultFile);
+	string strResult;
+	ASSERT_TRUE((bool)getline(Result, strResult)) << "the scenario wrote no result";
+
+	EXPECT_GT(GetResultNumber(strResult, "aim_settle_time"), 0.000);
+	EXPECT_LT(GetResultNumber(strResult, "aim_settle_time"), dScenarioMaxAimSettle);
+	EXPECT_LT(GetResultNumber(strResult, "aim_error"), dAimTolerance);
+	remove(pszScenarioResultFile);
+}
@@ -0,0 +1,100 @@
+/******************************************************************************
+	Description:	Checks the CStatusFramePlanner bus load math against the
+					robot's CAN devices
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "IOMap.h"
+#include "StatusFramePlanner.h"
+
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+// What one device on the bus reads, matching each subsystem's ConfigureStatusFrames().
+struct sPlannedDevice {
+	int				m_nID;
+	CanDeviceType	m_nType;
+	bool			m_bOutput;			// Output at 10 ms.
+	bool			m_bFeedback;		// Velocity at 10 ms.
+	bool			m_bPosition;		// Position at 10 ms.
+};
+
+// Every CAN device IOMap.h defines and the robot constructs. nHoodMotor has no subsystem yet.
+static const sPlannedDevice s_aRobotDevices[] = {
+	{nLeadDriveMotor1,		eCanTalonFX,	true,	true,	true},
+	{nFollowDriveMotor1,	eCanTalonFX,	false,	false,	false},
+	{nLeadDriveMotor2,		eCanTalonFX,	true,	true,	true},
+	{nFollowDriveMotor2,	eCanTalonFX,	false,	false,	false},
+	{nFlywheelMotor1,		eCanTalonFX,	true,	true,	false},
+	{nFlywheelMotor2,		eCanTalonFX,	false,	false,	false},
+	{nLiftMotor1,			eCanTalonFX,	true,	false,	false},
+	{nLiftMotor2,			eCanTalonFX,	false,	false,	false},
+	{nIntakeMotor2,			eCanSparkMax,	false,	false,	false},
+	{nTransferBack,			eCanSparkMax,	false,	false,	false},
+	{nTransferVertical,		eCanSparkMax,	false,	false,	false},
+	{nIntakeDeployMotor2,	eCanTalonSRX,	false,	false,	false}
+};
+
+// Frames per second of one device, status frames plus the roboRIO's control frame.
+const double dDefaultTalonFXRate	= (1000.0 / 10) + (1000.0 / 20) + (5 * 1000.0 / 160) + (1000.0 / 50) + (2 * 1000.0 / 250) + (1000.0 / nPhoenixControlPeriod);
+const double dDefaultTalonSRXRate	= (1000.0 / 10) + (1000.0 / 20) + (5 * 1000.0 / 160) + (2 * 1000.0 / 250) + (1000.0 / nPhoenixControlPeriod);
+const double dDefaultSparkMaxRate	= (1000.0 / 10) + (3 * 1000.0 / 20) + (1000.0 / 50) + (1000.0 / nSparkControlPeriod);
+// Planned, frames nobody reads go to their idle period.
+const double dPlannedFeedbackRate	= (2 * 1000.0 / 10) + (8 * 1000.0 / nPhoenixMaxFramePeriod) + (1000.0 / nPhoenixControlPeriod);
+const double dPlannedOutputRate		= (1000.0 / 10) + (9 * 1000.0 / nPhoenixMaxFramePeriod) + (1000.0 / nPhoenixControlPeriod);
+const double dPlannedIdleFXRate		= (1000.0 / 100) + (9 * 1000.0 / nPhoenixMaxFramePeriod) + (1000.0 / nPhoenixControlPeriod);
+const double dPlannedIdleSRXRate	= (1000.0 / 100) + (8 * 1000.0 / nPhoenixMaxFramePeriod) + (1000.0 / nPhoenixControlPeriod);
+const double dPlannedIdleSparkRate	= (1000.0 / 100) + (4 * 1000.0 / 500) + (1000.0 / nSparkControlPeriod);
+
+// Extended frame with 8 data bytes: 64 data bits, 67 of framing and 29 worst case stuff bits.
+TEST(StatusFramePlannerTest, FrameBits)
+{
+	EXPECT_DOUBLE_EQ(CStatusFramePlanner::GetFrameBits(nCanPayloadBytes), 160.0);
+	EXPECT_DOUBLE_EQ(CStatusFramePlanner::GetFrameBits(0), 80.0);
+}
+
+TEST(StatusFramePlannerTest, Utilization)
+{
+	// 100 frames per second of 160 bits on a 1 Mbit/s bus.
+	EXPECT_DOUBLE_EQ(CStatusFramePlanner::GetUtilization({10}), 0.016);
+	EXPECT_DOUBLE_EQ(CStatusFramePlanner::GetUtilization({10, 20, 20}), 0.032);
+	EXPECT_DOUBLE_EQ(CStatusFramePlanner::GetUtilization({}), 0.0);
+}
+
+// The devices are added without a controller behind them, so Apply() only plans.
+TEST(StatusFramePlannerTest, RobotBusLoad)
+{
+	CStatusFramePlanner* pPlanner = new CStatusFramePlanner();
+	int nTalonFX = 0, nTalonSRX = 0, nSparkMax = 0;
+	for (const sPlannedDevice& Device : s_aRobotDevices)
+	{
+		const int nDevice = (Device.m_nType == eCanSparkMax) ? pPlanner->AddSpark(nullptr) : pPlanner->AddTalon(nullptr, Device.m_nType);
+		if (Device.m_bOutput) pPlanner->Require(nDevice, eSignalOutput, 10);
+		if (Device.m_bFeedback) pPlanner->Require(nDevice, eSignalVelocity, 10);
+		if (Device.m_bPosition) pPlanner->Require(nDevice, eSignalPosition, 10);
+		nTalonFX += (Device.m_nType == eCanTalonFX);
+		nTalonSRX += (Device.m_nType == eCanTalonSRX);
+		nSparkMax += (Device.m_nType == eCanSparkMax);
+	}
+	pPlanner->Apply();
+
+	const double dFrameBits = CStatusFramePlanner::GetFrameBits(nCanPayloadBytes);
+	const double dHeartbeatRate = 1000.0 / nCanHeartbeatPeriod;
+	const double dDefaultRate = dHeartbeatRate + (nTalonFX * dDefaultTalonFXRate) + (nTalonSRX * dDefaultTalonSRXRate) + (nSparkMax * dDefaultSparkMaxRate);
+	// Drive leads and the first flywheel read output and feedback, the first lift motor only output.
+	const double dPlannedRate = dHeartbeatRate + (3 * dPlannedFeedbackRate) + dPlannedOutputRate + ((nTalonFX - 4) * dPlannedIdleFXRate) +
+								(nTalonSRX * dPlannedIdleSRXRate) + (nSparkMax * dPlannedIdleSparkRate);
+
+	EXPECT_EQ(nTalonFX, 8);
+	EXPECT_EQ(nTalonSRX, 1);
+	EXPECT_EQ(nSparkMax, 3);
+	EXPECT_NEAR(pPlanner->GetDefaultUtilization(), (dDefaultRate * dFrameBits) / dCanBitRate, 1e-9);
+	EXPECT_NEAR(pPlanner->GetPlannedUtilization(), (dPlannedRate * dFrameBits) / dCanBitRate, 1e-9);
+	// About 60% on the factory defaults, 35% planned.
+	EXPECT_NEAR(pPlanner->GetDefaultUtilization(), 0.604, 0.001);
+	EXPECT_NEAR(pPlanner->GetPlannedUtilization(), 0.353, 0.001);
+	delete pPlanner;
+}
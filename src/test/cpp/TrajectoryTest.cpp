@@ -0,0 +1,67 @@
+/******************************************************************************
+	Description:	Checks every holder of a trajectory shares the cached copy
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "Drive.h"
+#include "SensorSnapshot.h"
+#include "Telemetry.h"
+#include "TrajectoryConstants.h"
+
+#include <memory>
+#include <frc/Joystick.h>
+#include "gtest/gtest.h"
+
+using namespace frc;
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+// The desktop deploy directory is src/main/deploy, which has TestPath and nothing else.
+TEST(TrajectoryTest, CacheHandsOutOneCopy)
+{
+	CTrajectoryConstants* pConstants = new CTrajectoryConstants();
+	shared_ptr<const Trajectory> pFirst = pConstants->GetTrajectory(eTestPath);
+	ASSERT_NE(pFirst, nullptr) << "TestPath is missing from src/main/deploy/paths/output";
+
+	// Timed paths fall back to the test path slot.
+	shared_ptr<const Trajectory> pSecond = pConstants->GetTrajectory(eTaxiShot);
+	EXPECT_EQ(pFirst.get(), pSecond.get());
+	EXPECT_EQ(pFirst->States().data(), pSecond->States().data());
+	// Cache slot, pFirst and pSecond.
+	EXPECT_EQ(pFirst.use_count(), 3);
+
+	EXPECT_EQ(pConstants->GetTrajectory(eAdvancement1), nullptr);
+	delete pConstants;
+}
+
+// CDrive::SetTrajectory() hands the cached pointer to the follower, nothing copies the states.
+TEST(TrajectoryTest, DriveAndFollowerShareTheCache)
+{
+	CTelemetry* pTelemetry = new CTelemetry();
+	Joystick* pController = new Joystick(0);
+	sSensorSnapshot Snapshot;
+	CDrive* pDrive = new CDrive(pController, pTelemetry, &Snapshot);
+
+	pDrive->SetTrajectory(eTestPath);
+	shared_ptr<const Trajectory> pCached = pDrive->GetTrajectoryConstants()->GetTrajectory(eTestPath);
+	ASSERT_NE(pCached, nullptr) << "TestPath is missing from src/main/deploy/paths/output";
+	ASSERT_NE(pDrive->GetArmedTrajectory(), nullptr);
+	EXPECT_EQ(pDrive->GetArmedTrajectory(), pCached.get());
+	EXPECT_EQ(pDrive->GetArmedTrajectory()->States().data(), pCached->States().data());
+	// Cache slot, selected path, CDrive, CTrajectoryFollower and pCached.
+	EXPECT_EQ(pCached.use_count(), 5);
+
+	// Re-arming swaps references, it doesn't add any.
+	pDrive->SetTrajectory(eTestPath);
+	EXPECT_EQ(pDrive->GetArmedTrajectory()->States().data(), pCached->States().data());
+	EXPECT_EQ(pCached.use_count(), 5);
+
+	// A timed path disarms, the follower lets go of its reference.
+	pDrive->SetTrajectory(eTaxi2Shot);
+	EXPECT_EQ(pDrive->GetArmedTrajectory(), nullptr);
+	EXPECT_EQ(pCached.use_count(), 4);
+
+	delete pDrive;
+	delete pController;
+	delete pTelemetry;
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+	Description:	Measures the CVisionIngest handoff latency and jitter
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "VisionIngest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include <networktables/NetworkTableInstance.h>
+#include "gtest/gtest.h"
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+const int		nIngestTestPackets		= 500;
+const double	dIngestTestTimeout		= 1.000;	// s to wait for one packet before giving up.
+const double	dIngestTestMaxMedian	= 5.000;	// ms, generous so a loaded CI machine still passes.
+
+// Publish version 1 packets on a local instance and time each one from SetRaw() until
+// GetLatestPacket() returns it, the same read the robot loop makes.
+TEST(VisionIngestTest, HandoffLatencyAndJitter)
+{
+	nt::NetworkTableInstance Instance = nt::NetworkTableInstance::Create();
+	nt::NetworkTableEntry Entry = Instance.GetEntry("/SmartDashboard/processed_vision");
+	CTelemetry* pTelemetry = new CTelemetry();
+	CVisionIngest* pIngest = new CVisionIngest(pTelemetry);
+	pIngest->Start(Instance);
+
+	vector<double> vLatencies;
+	for (int n = 0; n < nIngestTestPackets; n++)
+	{
+		// The first byte changes every packet and is never 0xFF, so each one is new.
+		const unsigned char nRandVal = (unsigned char)(n % 0xFF);
+		const unsigned char aDetection[nVisionDetectionSize] = {0, 100, 0, 120, 0, 40, 0, 30, 100, eHub, 0, 0, 0x13, 0x88};
+		string strPacket = {(char)nRandVal, 1, (char)eFrontCamera};
+		strPacket.append((const char*)aDetection, nVisionDetectionSize);
+
+		const auto tStart = chrono::steady_clock::now();
+		Entry.SetRaw(strPacket);
+		while (true)
+		{
+			const CVisionPacket* pPacket = pIngest->GetLatestPacket();
+			const double dElapsed = chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+			if ((pPacket != nullptr) && (pPacket->m_nRandVal == nRandVal))
+			{
+				vLatencies.push_back(dElapsed * 1000.000);
+				break;
+			}
+			ASSERT_LT(dElapsed, dIngestTestTimeout) << "packet " << n << " never reached the robot loop";
+			this_thread::yield();
+		}
+	}
+
+	pIngest->Stop();
+	delete pIngest;
+	delete pTelemetry;
+	nt::NetworkTableInstance::Destroy(Instance);
+
+	const double dMean = accumulate(vLatencies.begin(), vLatencies.end(), 0.000) / vLatencies.size();
+	double dVariance = 0.000;
+	for (double dLatency : vLatencies) dVariance += (dLatency - dMean) * (dLatency - dMean);
+	const double dJitter = sqrt(dVariance / vLatencies.size());
+	sort(vLatencies.begin(), vLatencies.end());
+	const double dMedian = vLatencies[vLatencies.size() / 2];
+	const double dP99 = vLatencies[(vLatencies.size() * 99) / 100];
+
+	RecordProperty("MeanLatencyUs", to_string((int)(dMean * 1000.000)));
+	RecordProperty("MedianLatencyUs", to_string((int)(dMedian * 1000.000)));
+	RecordProperty("P99LatencyUs", to_string((int)(dP99 * 1000.000)));
+	RecordProperty("JitterUs", to_string((int)(dJitter * 1000.000)));
+	printf("Vision ingest handoff over %d packets: mean %.3f ms, median %.3f ms, p99 %.3f ms, jitter %.3f ms\n", nIngestTestPackets, dMean, dMedian, dP99, dJitter);
+
+	EXPECT_LT(dMedian, dIngestTestMaxMedian);
+}
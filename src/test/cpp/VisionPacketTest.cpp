@@ -0,0 +1,117 @@
+/******************************************************************************
+	Description:	Checks CVisionPacket decoding stays off the heap
+	Project:		2022 Rapid React Robot Code
+******************************************************************************/
+
+#include "LatestValue.h"
+#include "Vision.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace std;
+///////////////////////////////////////////////////////////////////////////////
+
+// Every operator new in the test program goes through here, so a test can count
+// what a block of code allocates. Both sides stay out of line, otherwise GCC sees
+// malloc() and free() meet operator new and delete and warns.
+static atomic<size_t> s_nAllocations{0};
+
+#if defined(__GNUC__)
+#define ALLOCATION_NOINLINE __attribute__((noinline))
+#else
+#define ALLOCATION_NOINLINE
+#endif
+
+ALLOCATION_NOINLINE void* operator new(size_t nSize)
+{
+	s_nAllocations++;
+	void* pMemory = malloc((nSize > 0) ? nSize : 1);
+	if (pMemory == nullptr) throw bad_alloc();
+	return pMemory;
+}
+
+ALLOCATION_NOINLINE void operator delete(void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+ALLOCATION_NOINLINE void operator delete(void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+
+/******************************************************************************
+	Description:	Build a version 1 packet the way the coprocessor sends it
+	Arguments:		unsigned char nRandVal, int nCount
+	Returns:		vector<char> - Raw packet
+******************************************************************************/
+static vector<char> BuildVersion1Packet(unsigned char nRandVal, int nCount)
+{
+	vector<char> vPacket = {(char)nRandVal, (char)nCount, (char)eFrontCamera};
+	for (int i = 0; i < nCount; i++)
+	{
+		const unsigned char aDetection[nVisionDetectionSize] = {0, (unsigned char)(100 + i), 0, 120, 0, 40, 0, 30, 200, eHub, 0, 0, 0x13, 0x88};
+		vPacket.insert(vPacket.end(), aDetection, aDetection + nVisionDetectionSize);
+	}
+	return vPacket;
+}
+
+// The ingest thread's path, decode into the write buffer, parse, hand over, read on the robot loop.
+TEST(VisionPacketTest, SteadyStateDoesNotAllocate)
+{
+	CLatestValue<CVisionPacket>* pLatest = new CLatestValue<CVisionPacket>();
+	vector<vector<char>> vPackets;
+	for (int n = 0; n < 8; n++) vPackets.push_back(BuildVersion1Packet((unsigned char)n, 1 + (n * 31)));
+
+	auto Receive = [&](const vector<char>& vPacket)
+	{
+		CVisionPacket& Packet = pLatest->GetWriteBuffer();
+		if (!Packet.Decode(vPacket.data(), vPacket.size())) return -1;
+		Packet.ParseDetections();
+		Packet.ParseBatch();
+		pLatest->Publish();
+		pLatest->Update();
+		return (int)pLatest->GetReadBuffer().m_nDetectionCount;
+	};
+
+	// Warm up every buffer once.
+	for (const vector<char>& vPacket : vPackets) Receive(vPacket);
+
+	const size_t nBefore = s_nAllocations;
+	int nDetections = 0;
+	for (int n = 0; n < 1000; n++) nDetections += Receive(vPackets[n % vPackets.size()]);
+	const size_t nAllocated = s_nAllocations - nBefore;
+
+	EXPECT_EQ(nAllocated, 0u);
+	EXPECT_GT(nDetections, 0);
+	delete pLatest;
+}
+
+TEST(VisionPacketTest, DecodesDetectionsInPlace)
+{
+	CVisionPacket* pPacket = new CVisionPacket();
+	const vector<char> vPacket = BuildVersion1Packet(7, 3);
+	ASSERT_TRUE(pPacket->Decode(vPacket.data(), vPacket.size()));
+	pPacket->ParseDetections();
+
+	EXPECT_EQ(pPacket->m_nDetectionCount, 3);
+	EXPECT_EQ(pPacket->m_kDetectionLocation, eFrontCamera);
+	EXPECT_EQ(pPacket->m_aDetections[2].m_nX, 102);
+	EXPECT_EQ(pPacket->m_aDetections[2].m_kClass, eHub);
+	EXPECT_EQ(pPacket->m_aDetections[2].m_nDepth, 5000);
+	delete pPacket;
+}
+
+TEST(VisionPacketTest, ClampsCountToBytesReceived)
+{
+	CVisionPacket* pPacket = new CVisionPacket();
+	vector<char> vPacket = BuildVersion1Packet(7, 3);
+	vPacket[1] = (char)200;
+	ASSERT_TRUE(pPacket->Decode(vPacket.data(), vPacket.size()));
+	EXPECT_EQ(pPacket->m_nDetectionCount, 3);
+	delete pPacket;
+}
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Dump a flight recorder log (flight_N.bin) as CSV.
+
+Usage: flight_reader.py flight_0.bin [output.csv]
+
+The layout must match sFlightRecorderHeader and sFlightRecord in
+src/main/include/FlightRecorder.h.
+"""
+import csv
+import struct
+import sys
+
+HEADER = struct.Struct("<6I")
+RECORD = struct.Struct("<d7f4B")
+MAGIC = 0x43455246
+VERSION = 1
+
+FIELDS = [
+    "timestamp", "left_voltage", "right_voltage", "left_velocity", "right_velocity",
+    "left_position", "right_position", "flywheel_velocity", "mode", "auto_state",
+    "teleop_state", "vertical_ball", "back_ball", "intake_down", "intake_up",
+]
+MODES = {0: "disabled", 1: "autonomous", 2: "teleop", 3: "test"}
+
+
+def read_log(path):
+    with open(path, "rb") as log:
+        data = log.read()
+
+    magic, version, record_size, capacity, count, dropped = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError(f"{path} is not a flight recorder log")
+    if version != VERSION or record_size != RECORD.size:
+        raise ValueError(f"{path} is log version {version} with {record_size} byte records, "
+                         f"this reader handles version {VERSION} with {RECORD.size} byte records")
+
+    records = []
+    for i in range(min(count, capacity)):
+        values = RECORD.unpack_from(data, HEADER.size + i * record_size)
+        flags = values[11]
+        records.append(list(values[:8]) + [MODES.get(values[8], values[8]), values[9], values[10],
+                       bool(flags & 0x01), bool(flags & 0x02), bool(flags & 0x04), bool(flags & 0x08)])
+    return records, dropped
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+
+    records, dropped = read_log(sys.argv[1])
+    output = open(sys.argv[2], "w", newline="") if len(sys.argv) > 2 else sys.stdout
+    writer = csv.writer(output)
+    writer.writerow(FIELDS)
+    writer.writerows(records)
+    print(f"{len(records)} records, {dropped} dropped", file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
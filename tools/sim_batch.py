@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""Run autonomous routines many times in the desktop simulation and summarize them.
+
+Usage: sim_batch.py [--paths NAME ...] [--aim DEGREES ...] [--runs N] [--jobs N] [--exe PATH] [--output results.jsonl]
+
+Build the desktop program first with ./gradlew installFrcUserProgramLinuxx86-64ReleaseExecutable.
+Each run is its own process with its own HAL sim. It is started from the repo root, so the
+deploy directory resolves, and the SIM_* environment variables read by
+CSimScenario::FromEnvironment() in src/main/cpp/SimScenario.cpp are set for it. The
+battery, friction and sensor noise are drawn from a seeded generator, so a batch can be
+repeated exactly.
+
+--aim runs heading lock steps instead of paths: the robot sits idle in autonomous, the
+target tracker is fed simulated hub frames at the given bearing and the robot aims at the
+hub's track the way teleop does. The time to settle on it is reported. Steps have to be
+inside the camera's 34.5 degree half field of view.
+"""
+import argparse
+import json
+import os
+import random
+import statistics
+import subprocess
+import sys
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+
+# Must match enum Paths in src/main/include/TrajectoryConstants.h.
+PATHS = {
+    "eTestPath": 2,
+    "eDumbTaxi": 3,
+    "eTaxiShot": 4,
+    "eTaxi2Shot": 5,
+    "eLessDumbTaxi1": 6,
+    "eAdvancement1": 9,
+    "eAdvancement2": 10,
+    "eTerminator": 11,
+}
+# Paths that follow a deployed trajectory, matching CTrajectoryConstants::GetPathName(). The
+# robot falls back to TestPath when one isn't deployed, so those runs would measure the wrong path.
+TRAJECTORIES = {"eTestPath": "TestPath", "eAdvancement1": "Advancement1", "eAdvancement2": "Advancement2"}
+# Balls the intake can reach on each path.
+FIELD_BALLS = {"eTaxi2Shot": 1, "eLessDumbTaxi1": 1, "eTerminator": 2}
+AUTO_IDLE = 1
+AIM_DURATION = 3.0
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_EXE = os.path.join(REPO, "build", "install", "frcUserProgram", "linuxx86-64", "release", "frcUserProgram")
+DEPLOY = os.path.join(REPO, "src", "main", "deploy")
+
+
+def perturbation(rng):
+    return {
+        "SIM_BATTERY": f"{rng.uniform(11.8, 13.0):.3f}",
+        "SIM_BATTERY_RESISTANCE": f"{rng.uniform(0.012, 0.030):.4f}",
+        "SIM_FRICTION": f"{rng.uniform(0.7, 1.5):.3f}",
+        "SIM_ENCODER_NOISE": f"{rng.uniform(0.0, 0.05):.4f}",
+        "SIM_GYRO_NOISE": f"{rng.uniform(0.0, 0.2):.4f}",
+    }
+
+
+def is_deployed(name):
+    trajectory = TRAJECTORIES.get(name)
+    if trajectory is None:
+        return True
+    return (os.path.exists(os.path.join(DEPLOY, "paths", "binary", trajectory + ".traj")) or
+            os.path.exists(os.path.join(DEPLOY, "paths", "output", trajectory + ".wpilib.json")))
+
+
+def path_env(name):
+    return {"SIM_PATH": str(PATHS[name]), "SIM_FIELD_BALLS": str(FIELD_BALLS.get(name, 0))}
+
+
+def aim_env(angle, frame_period):
+    return {"SIM_PATH": str(AUTO_IDLE), "SIM_FIELD_BALLS": "0", "SIM_AIM": str(angle),
+            "SIM_AIM_FRAME_PERIOD": str(frame_period), "SIM_DURATION": str(AIM_DURATION)}
+
+
+def run(exe, name, seed, env_overrides, timeout):
+    with tempfile.TemporaryDirectory() as scratch:
+        result_file = os.path.join(scratch, "result.jsonl")
+        env = dict(os.environ, SIM_SEED=str(seed), SIM_RESULT=result_file, **env_overrides)
+        env.pop("HALSIM_EXTENSIONS", None)
+        try:
+            subprocess.run([exe], cwd=REPO, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                           timeout=timeout, check=False)
+        except subprocess.TimeoutExpired:
+            return {"name": name, "seed": seed, "error": "timeout"}
+        if not os.path.exists(result_file):
+            return {"name": name, "seed": seed, "error": "no result"}
+        with open(result_file) as results:
+            result = json.loads(results.readline())
+    result["name"] = name
+    return result
+
+
+def summarize(values):
+    if not values:
+        return "n/a"
+    ordered = sorted(values)
+    p95 = ordered[min(len(ordered) - 1, int(0.95 * len(ordered)))]
+    return f"mean {statistics.fmean(values):7.3f}  sd {statistics.pstdev(values):6.3f}  p95 {p95:7.3f}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--paths", nargs="+", choices=list(PATHS))
+    parser.add_argument("--aim", nargs="+", type=float, default=[], metavar="DEGREES", help="heading lock step sizes, within +/-34.5")
+    parser.add_argument("--frame-period", type=float, default=0.1, help="seconds between hub frames for --aim")
+    parser.add_argument("--runs", type=int, default=100, help="runs per path")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count())
+    parser.add_argument("--seed", type=int, default=2022)
+    parser.add_argument("--exe", default=DEFAULT_EXE)
+    parser.add_argument("--timeout", type=float, default=120.0, help="seconds per run")
+    parser.add_argument("--output", help="write every run as JSON lines")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.exe):
+        print(f"{args.exe} not found, build the desktop program first", file=sys.stderr)
+        return 1
+
+    if args.paths is None:
+        args.paths = [] if args.aim else list(PATHS)
+    missing = [name for name in args.paths if not is_deployed(name)]
+    for name in missing:
+        print(f"{name}: skipped, {TRAJECTORIES[name]} has no trajectory in {DEPLOY}", file=sys.stderr)
+    args.paths = [name for name in args.paths if name not in missing]
+
+    rng = random.Random(args.seed)
+    jobs = []
+    for name in args.paths:
+        for _ in range(args.runs):
+            jobs.append((name, rng.randrange(1 << 31), dict(perturbation(rng), **path_env(name))))
+    aims = [f"aim {angle:g}" for angle in args.aim]
+    for name, angle in zip(aims, args.aim):
+        for _ in range(args.runs):
+            jobs.append((name, rng.randrange(1 << 31), dict(perturbation(rng), **aim_env(angle, args.frame_period))))
+
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        results = list(pool.map(lambda job: run(args.exe, job[0], job[1], job[2], args.timeout), jobs))
+
+    if args.output:
+        with open(args.output, "w") as output:
+            for result in results:
+                output.write(json.dumps(result) + "\n")
+
+    for name in args.paths:
+        runs = [result for result in results if result["name"] == name]
+        good = [result for result in runs if "error" not in result]
+        print(f"{name}: {len(good)}/{len(runs)} runs completed")
+        print(f"  pose error (m)       {summarize([r['pose_error'] for r in good if r['pose_error'] >= 0])}")
+        print(f"  odometry error (m)   {summarize([r['odometry_error'] for r in good])}")
+        print(f"  first shot (s)       {summarize([r['first_shot_time'] for r in good if r['first_shot_time'] >= 0])}")
+        print(f"  balls scored         {summarize([r['balls_scored'] for r in good])}")
+    for name in aims:
+        runs = [result for result in results if result["name"] == name]
+        good = [result for result in runs if "error" not in result]
+        settled = [result for result in good if result["aim_settle_time"] >= 0]
+        print(f"{name} deg, frames every {args.frame_period:g}s: {len(settled)}/{len(runs)} runs settled")
+        print(f"  settle time (s)      {summarize([r['aim_settle_time'] for r in settled])}")
+        print(f"  final error (deg)    {summarize([r['aim_error'] for r in good])}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Encode and decode version 2 vision packets, and stand in for the coprocessor.
+
+Usage: vision_protocol.py publish [--server HOST] [--rate HZ] [--hub-x PIXELS] [--hub-depth MM]
+       vision_protocol.py write packet.bin [--hub-x PIXELS] [--hub-depth MM]
+       vision_protocol.py read packet.bin
+
+The layout must match the table at the top of src/main/include/VisionProtocol.h. publish
+sends a synthetic hub frame to /SmartDashboard/processed_vision at the given rate, which
+is what CVisionIngest listens to, so the robot program (real or desktop simulation) can
+be run without the camera. It needs pynetworktables. write and read go through a file,
+for checking a packet captured off the robot.
+"""
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+HEADER = struct.Struct(">HBBIQHH")
+DETECTION = struct.Struct(">HHHHBBHI")
+TRAILER = struct.Struct(">I")
+MAGIC = 0xFF56  # Starts 0xFF, which never starts a valid version 1 packet.
+VERSION = 2
+MAX_DETECTIONS = 255
+
+# Must match enum DetectionClass and DetectionLocation in src/main/include/Vision.h.
+CLASSES = {"cargo": 0, "hub": 1, "red_cargo": 2, "blue_cargo": 3}
+LOCATIONS = {"front": 0, "back": 1}
+FIELDS = ["x", "y", "width", "height", "confidence", "class", "depth"]
+
+
+def encode(location, sequence, capture_time_us, detections):
+    """Build one packet. Each detection is a dict with the keys in FIELDS."""
+    if len(detections) > MAX_DETECTIONS:
+        raise ValueError(f"{len(detections)} detections, at most {MAX_DETECTIONS} fit a packet")
+    body = bytearray(HEADER.pack(MAGIC, VERSION, location, sequence & 0xFFFFFFFF, capture_time_us,
+                                 len(detections), DETECTION.size))
+    for detection in detections:
+        body += DETECTION.pack(detection["x"], detection["y"], detection["width"], detection["height"],
+                               detection["confidence"], detection["class"], 0, detection["depth"])
+    body += TRAILER.pack(zlib.crc32(body))
+    return bytes(body)
+
+
+def decode(packet):
+    """Check and unpack one packet, raises ValueError the same places CVisionPacketView::Validate() fails."""
+    if len(packet) < HEADER.size + TRAILER.size:
+        raise ValueError(f"{len(packet)} bytes is shorter than a header")
+    magic, version, location, sequence, capture_time_us, count, detection_size = HEADER.unpack_from(packet, 0)
+    if magic != MAGIC or version != VERSION or detection_size != DETECTION.size:
+        raise ValueError(f"magic {magic:#06x} version {version} detection size {detection_size}, "
+                         f"expected {MAGIC:#06x} version {VERSION} detection size {DETECTION.size}")
+    if count > MAX_DETECTIONS or len(packet) != HEADER.size + count * DETECTION.size + TRAILER.size:
+        raise ValueError(f"{count} detections do not match {len(packet)} bytes")
+    (crc,) = TRAILER.unpack_from(packet, len(packet) - TRAILER.size)
+    if crc != zlib.crc32(packet[:-TRAILER.size]):
+        raise ValueError("CRC mismatch")
+
+    detections = []
+    for i in range(count):
+        x, y, width, height, confidence, kind, _, depth = DETECTION.unpack_from(packet, HEADER.size + i * DETECTION.size)
+        detections.append(dict(zip(FIELDS, (x, y, width, height, confidence, kind, depth))))
+    return {"location": location, "sequence": sequence, "capture_time_us": capture_time_us, "detections": detections}
+
+
+def hub_frame(args, sequence):
+    hub = {"x": args.hub_x, "y": 120, "width": 60, "height": 24, "confidence": 230, "class": CLASSES["hub"],
+           "depth": args.hub_depth}
+    return encode(LOCATIONS["front"], sequence, time.monotonic_ns() // 1000, [hub])
+
+
+def publish(args):
+    try:
+        from networktables import NetworkTables
+    except ImportError:
+        print("publish needs pynetworktables (pip install pynetworktables)", file=sys.stderr)
+        return 1
+
+    NetworkTables.initialize(server=args.server)
+    table = NetworkTables.getTable("SmartDashboard")
+    sequence = 0
+    while True:
+        table.putRaw("processed_vision", hub_frame(args, sequence))
+        NetworkTables.flush()
+        sequence += 1
+        time.sleep(1.0 / args.rate)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["publish", "write", "read"])
+    parser.add_argument("file", nargs="?", help="packet file for write and read")
+    parser.add_argument("--server", default="127.0.0.1", help="robot address, the default is the desktop simulation")
+    parser.add_argument("--rate", type=float, default=20.0, help="frames per second")
+    parser.add_argument("--hub-x", type=int, default=160, help="hub center in pixels, 160 is dead ahead")
+    parser.add_argument("--hub-depth", type=int, default=5180, help="hub distance (mm)")
+    args = parser.parse_args()
+
+    if args.command == "publish":
+        return publish(args)
+    if args.file is None:
+        parser.error(f"{args.command} needs a packet file")
+    if args.command == "write":
+        with open(args.file, "wb") as output:
+            output.write(hub_frame(args, 0))
+        return 0
+
+    with open(args.file, "rb") as packet:
+        decoded = decode(packet.read())
+    print(f"location {decoded['location']} sequence {decoded['sequence']} capture {decoded['capture_time_us']} us")
+    for detection in decoded["detections"]:
+        print("  " + "  ".join(f"{field} {detection[field]}" for field in FIELDS))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())